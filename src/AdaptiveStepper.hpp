@@ -0,0 +1,267 @@
+// ----------------------------------------------------------------------------
+// AdaptiveStepper.hpp
+//
+//  Created on: 18 Oct 2026
+//      Author: Kiwon Um
+//        Mail: kiwon.um@telecom-paris.fr
+//
+// Description: Adaptive time step controller for the rigid body solver
+//
+// Copyright 2020-2024 Kiwon Um
+//
+// The copyright to the computer program(s) herein is the property of Kiwon Um,
+// Telecom Paris, France. The program(s) may be used and/or copied only with
+// the written permission of Kiwon Um or in accordance with the terms and
+// conditions stipulated in the agreement/contract under which the program(s)
+// have been supplied.
+// ----------------------------------------------------------------------------
+
+#ifndef _ADAPTIVESTEPPER_HPP_
+#define _ADAPTIVESTEPPER_HPP_
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <vector>
+
+#include "RigidSolver.hpp"
+
+// Controls the time step of a RigidSolver by step doubling: every step is
+// taken once with dt and twice with dt/2, and the difference between both
+// results estimates the local error, relative to the size of the bodies. The
+// time step grows in quiet phases and shrinks when the error exceeds the
+// tolerance or when an impulsive event occurs during the step. Once the
+// error is far below the tolerance, steps of the same size are taken alone,
+// with an estimate every few steps only.
+template<typename Policy>
+class AdaptiveStepperT {
+public:
+  typedef typename Policy::Real Real;
+  typedef RigidSolverT<Policy> Solver;
+  typedef typename Solver::Body Body;
+
+  // What happened to one attempted step
+  struct StepReport {
+    tIndex step;    // Solver step count after the attempt
+    Real t;        // Simulation time at the beginning of the attempt
+    Real dt;       // Attempted time step
+    Real error;    // Error estimate relative to the tolerance
+    bool accepted;
+    bool event;     // An impulsive event happened during the attempt
+  };
+
+  // Aggregated statistics since the last init()
+  struct Stats {
+    tIndex accepted;
+    tIndex rejected;
+    Real dtMin;     // Smallest accepted step
+    Real dtMax;     // Largest accepted step
+    tIndex solverSteps;  // Calls to the solver, including the error estimates
+  };
+
+  typedef std::function<void(const StepReport &)> ReportCallback;
+
+  explicit AdaptiveStepperT(
+    Solver *solver = nullptr,
+    const Real tol = 1e-2,
+    const Real dtMin = 1e-4,
+    const Real dtMax = 1.0/30.0)
+    : _solver(solver), _tol(tol), _dtMin(dtMin), _dtMax(dtMax)
+  {
+    init(solver);
+  }
+
+  void init(Solver *solver) {
+    _solver = solver;
+    _dt = _dtMin;
+    _stats.accepted = 0;
+    _stats.rejected = 0;
+    _stats.solverSteps = 0;
+    _unchecked = 0;
+    _lastError = std::numeric_limits<Real>::infinity();
+    _checkedDt = 0;
+    _stats.dtMin = _dtMax;
+    _stats.dtMax = 0;
+  }
+
+  void setTolerance(const Real tol) { _tol = tol; }
+  void setBounds(const Real dtMin, const Real dtMax) {
+    _dtMin = dtMin;
+    _dtMax = dtMax;
+    _dt = std::min(std::max(_dt, _dtMin), _dtMax);
+  }
+  void setReportCallback(const ReportCallback &cb) { _report = cb; }
+
+  // Time step the controller will try next
+  Real nextDt() const { return _dt; }
+  const Stats& stats() const { return _stats; }
+
+  // Advance the simulation by the given duration with as many adaptive steps
+  // as needed. Returns the number of accepted steps.
+  tIndex advance(const Real duration) {
+    tIndex n = 0;
+    Real remaining = duration;
+    while(remaining > static_cast<Real>(1e-3)*_dtMin) {
+      remaining -= step(remaining);
+      ++n;
+    }
+    return n;
+  }
+
+  // Take one accepted step no longer than dtLimit. Returns the step taken.
+  Real step(const Real dtLimit) {
+    const bool verbose = _solver->verbose();
+    _solver->setVerbose(false);
+
+    Real taken = 0;
+    for(tIndex attempt = 0; !taken; ++attempt) {
+      const bool clipped = (_dt > dtLimit);
+      Real dt = clipped ? dtLimit : _dt;
+      // Give up refining a step that keeps failing, e.g., on a non-finite
+      // state, rather than looping forever
+      if(attempt >= MAX_ATTEMPTS) dt = std::min(_dtMin, dtLimit);
+      _solver->saveState(_s0);
+
+      StepReport rep;
+      rep.t = _s0.t;
+      rep.dt = dt;
+      rep.error = 0;
+      rep.event = false;
+      rep.accepted = false;
+      bool checked = true;
+
+      if(dt <= _dtMin) {
+        // Cannot refine any further: accept unconditionally
+        solverStep(dt);
+        rep.event = (_solver->eventCount() != _s0.events);
+        rep.accepted = true;
+      } else if(_unchecked < QUIET_STEPS && _lastError <= QUIET_ERROR && dt <= _checkedDt) {
+        // Quiet phase: the last estimate at this step size was well within
+        // the tolerance, so take the step alone and check every few steps
+        solverStep(dt);
+        if(_solver->eventCount() == _s0.events) {
+          rep.error = _lastError;
+          rep.accepted = true;
+          checked = false;
+        } else {
+          _solver->restoreState(_s0);
+        }
+      }
+
+      if(!rep.accepted) {
+        // One full step ...
+        solverStep(dt);
+        _solver->saveState(_full);
+        const bool fullEvent = (_solver->eventCount() != _s0.events);
+
+        // ... against two half steps
+        _solver->restoreState(_s0);
+        solverStep(dt/2);
+        solverStep(dt/2);
+        _solver->saveState(_half);
+        rep.event = fullEvent || (_solver->eventCount() != _s0.events);
+        rep.error = errorNorm(_full, _half, _solver->bodies(), dt)/_tol;
+        rep.accepted = (!rep.event && rep.error <= 1);
+      }
+      rep.step = _solver->stepCount();
+
+      if(rep.accepted) {
+        taken = dt;
+        ++_stats.accepted;
+        _stats.dtMin = std::min(_stats.dtMin, dt);
+        _stats.dtMax = std::max(_stats.dtMax, dt);
+        if(checked) {
+          _unchecked = 0;
+          _lastError = rep.error;
+          _checkedDt = dt;
+        } else {
+          ++_unchecked;
+        }
+        // A clipped step may only raise the step we can afford
+        if(checked)
+          _dt = clipped ? std::max(_dt, nextStep(dt, rep.error)) : nextStep(dt, rep.error);
+      } else {
+        _solver->restoreState(_s0);
+        ++_stats.rejected;
+        _lastError = std::numeric_limits<Real>::infinity();
+        // Resolve impulsive events with the finest step
+        _dt = rep.event ? _dtMin : nextStep(dt, rep.error);
+      }
+
+      if(_report)
+        _report(rep);
+    }
+
+    _solver->setVerbose(verbose);
+    return taken;
+  }
+
+private:
+  static const tIndex MAX_ATTEMPTS = 32;  // Per step, before forcing dtMin
+  static const tIndex QUIET_STEPS = 3;    // Unchecked steps between checks
+  static constexpr Real QUIET_ERROR = 0.1;  // Relative error of a quiet phase
+
+  void solverStep(const Real dt) {
+    _solver->step(dt);
+    ++_stats.solverSteps;
+  }
+
+  // Local error of the first order integrator is O(dt^2). A non-finite
+  // error shrinks the step as much as allowed.
+  Real nextStep(const Real dt, const Real error) const {
+    const Real safety = 0.9, maxGrowth = 2.0, maxShrink = 0.2;
+    const Real factor = !std::isfinite(error) ? maxShrink :
+      (error > 0) ?
+      std::min(maxGrowth, std::max(maxShrink, safety/std::sqrt(error))) :
+      maxGrowth;
+    return std::min(std::max(dt*factor, _dtMin), _dtMax);
+  }
+
+  // Largest deviation between both solutions over all bodies, relative to
+  // the body: positions in units of the body extent plus the distance it
+  // travels during the step, and orientations in radians. Velocities are
+  // scaled by the step so they count as their effect on the next step.
+  static Real errorNorm(
+    const typename Solver::State &sa, const typename Solver::State &sb,
+    const std::vector<Body *> &bodies, const Real dt) {
+    Real err = 0;
+    for(std::size_t i = 0; i < sa.bodies.size(); ++i) {
+      const BodyStateT<Policy> &a = sa.bodies[i], &b = sb.bodies[i];
+      const Real scale = std::max(
+        bodies[i]->boundingRadius() + std::max(a.V.length(), b.V.length())*dt,
+        std::numeric_limits<Real>::min());
+      const typename Policy::Quat dq = glm::inverse(a.q)*b.q;
+      const Real angle =
+        2*std::sqrt(dq.x*dq.x + dq.y*dq.y + dq.z*dq.z);
+      const Real e[4] = {
+        static_cast<Real>((a.X - b.X - cellOffset<typename Policy::PosReal>(a.cell, b.cell)).length())/scale,
+        (a.V - b.V).length()*dt/scale,
+        angle,
+        (a.omega - b.omega).length()*dt };
+      for(const Real ei : e) {
+        // std::max would drop a NaN
+        if(!std::isfinite(ei)) return std::numeric_limits<Real>::infinity();
+        err = std::max(err, ei);
+      }
+    }
+    return err;
+  }
+
+  Solver *_solver;
+  Real _tol;      // Error tolerance per step, relative to the body extent
+  Real _dtMin, _dtMax;
+  Real _dt;       // Next time step to try
+  tIndex _unchecked;  // Steps taken since the last error estimate
+  Real _lastError;    // Last estimate, relative to the tolerance
+  Real _checkedDt;    // Step size of the last estimate
+  Stats _stats;
+  ReportCallback _report;
+
+  // Scratch states, kept to avoid reallocating on every step
+  typename Solver::State _s0, _full, _half;
+};
+
+typedef AdaptiveStepperT<FloatPrecision> AdaptiveStepper;
+
+#endif  /* _ADAPTIVESTEPPER_HPP_ */
@@ -0,0 +1,168 @@
+// ----------------------------------------------------------------------------
+// Aerodynamics.hpp
+//
+//  Created on: 18 Oct 2026
+//      Author: Kiwon Um
+//        Mail: kiwon.um@telecom-paris.fr
+//
+// Description: Per-face aerodynamic drag and lift (DO NOT DISTRIBUTE!)
+//
+// Copyright 2020-2024 Kiwon Um
+//
+// The copyright to the computer program(s) herein is the property of Kiwon Um,
+// Telecom Paris, France. The program(s) may be used and/or copied only with
+// the written permission of Kiwon Um or in accordance with the terms and
+// conditions stipulated in the agreement/contract under which the program(s)
+// have been supplied.
+// ----------------------------------------------------------------------------
+
+#ifndef _AERODYNAMICS_HPP_
+#define _AERODYNAMICS_HPP_
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "ForceGenerators.hpp"
+#include "Mesh.h"
+
+// Flat-plate model applied to every triangle of a body's mesh. A face of
+// area A and outward normal n moving at u relative to the air is pushed
+// only when it faces the flow (n.u > 0), by
+//
+//   F = -1/2 rho A (n.u) [Cd u + Cl (|u| n - (n.u) u/|u|)]
+//
+// i.e., drag along -u scaled by the projected area, and lift along the part
+// of -n orthogonal to u. The mesh is expressed in body space (centered at
+// the center of mass), as for the rendering.
+template<typename Policy>
+class AerodynamicForcesT : public ForceGeneratorT<Policy> {
+public:
+  typedef typename Policy::Real Real;
+  typedef typename Policy::Vec Vec;
+  typedef BodyAttributesT<Policy> Body;
+
+  static const tIndex BATCH = 8;   // Faces processed together
+
+  explicit AerodynamicForcesT(
+    const Vec &wind = Vec(0), const Real density = 1.225)
+    : _wind(wind), _rho(density) {}
+
+  void setWind(const Vec &wind) { _wind = wind; }
+  void setDensity(const Real rho) { _rho = rho; }
+
+  // Build the face table of the given body from its mesh
+  void addBody(
+    const tIndex body, const Mesh &mesh, const Real Cd = 1, const Real Cl = 0.5) {
+    const std::vector<glm::vec3> &P = mesh.vertexPositions();
+    const std::vector<glm::vec3> &N = mesh.vertexNormals();
+    const std::vector<glm::uvec3> &T = mesh.triangleIndices();
+
+    FaceTable ft;
+    ft.body = body;
+    ft.Cd = Cd;
+    ft.Cl = Cl;
+    for(const glm::uvec3 &t : T) {
+      const glm::vec3 c = (P[t[0]] + P[t[1]] + P[t[2]])/3.0f;
+      glm::vec3 n = 0.5f*glm::cross(P[t[1]] - P[t[0]], P[t[2]] - P[t[0]]);
+      const float area = glm::length(n);
+      if(area <= 0) continue;
+      n /= area;
+      // Trust the shading normals for the orientation of badly wound faces
+      if(N.size() == P.size() && glm::dot(n, N[t[0]] + N[t[1]] + N[t[2]]) < 0)
+        n = -n;
+      ft.push(c, n, area);
+    }
+    // Pad with zero-area faces to whole batches
+    while(ft.area.size() % BATCH)
+      ft.push(glm::vec3(0), glm::vec3(0), 0);
+    _tables.push_back(ft);
+  }
+  void clearBodies() { _tables.clear(); }
+
+  tIndex apply(
+    const std::vector<Body *> &bodies, const Real, const Real) override {
+    for(const FaceTable &ft : _tables) {
+      Body &b = *bodies[ft.body];
+      // Work in body space: only the body velocities are rotated, not faces
+      const Vec v = b.toBody(b.V - _wind);
+      const Vec w = b.toBody(b.omega);
+      Vec f, tau;
+      accumulate(ft, v, w, f, tau);
+      b.F += b.toWorld(f);
+      b.tau += b.toWorld(tau);
+    }
+    return 0;
+  }
+
+private:
+  // Faces in structure-of-arrays layout, body space
+  struct FaceTable {
+    tIndex body;
+    Real Cd, Cl;
+    std::vector<Real> cx, cy, cz;   // Centroids
+    std::vector<Real> nx, ny, nz;   // Unit normals
+    std::vector<Real> area;
+
+    void push(const glm::vec3 &c, const glm::vec3 &n, const Real a) {
+      cx.push_back(c.x); cy.push_back(c.y); cz.push_back(c.z);
+      nx.push_back(n.x); ny.push_back(n.y); nz.push_back(n.z);
+      area.push_back(a);
+    }
+  };
+
+  // Sum of forces and torques of all faces, given the body's linear and
+  // angular velocities relative to the air. The inner loop runs over the
+  // lanes of one batch without dependencies between them, so it compiles
+  // to SIMD code; lanes are reduced once at the end.
+  void accumulate(
+    const FaceTable &ft, const Vec &v, const Vec &w, Vec &f, Vec &tau) const {
+    Real fx[BATCH] = {0}, fy[BATCH] = {0}, fz[BATCH] = {0};
+    Real tx[BATCH] = {0}, ty[BATCH] = {0}, tz[BATCH] = {0};
+    const Real k = -static_cast<Real>(0.5)*_rho;
+    const Real Cd = ft.Cd, Cl = ft.Cl;
+    const Real tiny = 1e-12;
+
+    const std::size_t n = ft.area.size();
+    for(std::size_t i0 = 0; i0 < n; i0 += BATCH) {
+      const Real *cx = &ft.cx[i0], *cy = &ft.cy[i0], *cz = &ft.cz[i0];
+      const Real *nx = &ft.nx[i0], *ny = &ft.ny[i0], *nz = &ft.nz[i0];
+      const Real *a = &ft.area[i0];
+      for(tIndex l = 0; l < BATCH; ++l) {
+        // Face velocity u = v + w x c
+        const Real ux = v[0] + w[1]*cz[l] - w[2]*cy[l];
+        const Real uy = v[1] + w[2]*cx[l] - w[0]*cz[l];
+        const Real uz = v[2] + w[0]*cy[l] - w[1]*cx[l];
+        const Real un = std::max(nx[l]*ux + ny[l]*uy + nz[l]*uz, static_cast<Real>(0));
+        const Real u = std::sqrt(ux*ux + uy*uy + uz*uz + tiny);
+
+        const Real s = k*a[l]*un;
+        const Real sd = s*(Cd - Cl*un/u);   // Coefficient of u
+        const Real sl = s*Cl*u;             // Coefficient of n
+        const Real Fx = sd*ux + sl*nx[l];
+        const Real Fy = sd*uy + sl*ny[l];
+        const Real Fz = sd*uz + sl*nz[l];
+
+        fx[l] += Fx; fy[l] += Fy; fz[l] += Fz;
+        tx[l] += cy[l]*Fz - cz[l]*Fy;
+        ty[l] += cz[l]*Fx - cx[l]*Fz;
+        tz[l] += cx[l]*Fy - cy[l]*Fx;
+      }
+    }
+
+    f = Vec(0);
+    tau = Vec(0);
+    for(tIndex l = 0; l < BATCH; ++l) {
+      f += Vec(fx[l], fy[l], fz[l]);
+      tau += Vec(tx[l], ty[l], tz[l]);
+    }
+  }
+
+  Vec _wind;       // Air velocity
+  Real _rho;       // Air density
+  std::vector<FaceTable> _tables;
+};
+
+typedef AerodynamicForcesT<FloatPrecision> AerodynamicForces;
+
+#endif  /* _AERODYNAMICS_HPP_ */
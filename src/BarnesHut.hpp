@@ -0,0 +1,278 @@
+// ----------------------------------------------------------------------------
+// BarnesHut.hpp
+//
+//  Created on: 18 Oct 2026
+//      Author: Kiwon Um
+//        Mail: kiwon.um@telecom-paris.fr
+//
+// Description: Barnes-Hut mutual gravitation between rigid bodies (DO NOT DISTRIBUTE!)
+//
+// Copyright 2020-2024 Kiwon Um
+//
+// The copyright to the computer program(s) herein is the property of Kiwon Um,
+// Telecom Paris, France. The program(s) may be used and/or copied only with
+// the written permission of Kiwon Um or in accordance with the terms and
+// conditions stipulated in the agreement/contract under which the program(s)
+// have been supplied.
+// ----------------------------------------------------------------------------
+
+#ifndef _BARNESHUT_HPP_
+#define _BARNESHUT_HPP_
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "ForceGenerators.hpp"
+#include "Parallel.hpp"
+
+// Mutual gravitation F_i = sum_j G*M_i*M_j*(X_j - X_i)/(r^2 + eps^2)^(3/2)
+// approximated with an octree: a cell seen under an angle smaller than the
+// opening angle theta acts as a point mass at its center of mass. Costs
+// O(n log n) instead of O(n^2); theta = 0 gives the exact sum.
+// The tree is built on positions (Pos) relative to the cell of the first
+// target; accelerations are accumulated in the solver's Real.
+template<typename Policy>
+class BarnesHutGravityT : public ForceGeneratorT<Policy> {
+public:
+  typedef typename Policy::Real Real;
+  typedef typename Policy::PosReal PosReal;
+  typedef typename Policy::Vec Vec;
+  typedef typename Policy::Pos Pos;
+  typedef BodyAttributesT<Policy> Body;
+
+  explicit BarnesHutGravityT(
+    const Real G = 6.674e-11, const Real theta = 0.5,
+    const Real softening = 1e-3, const tIndex leafSize = 8)
+    : _G(G), _theta(theta), _eps2(softening*softening),
+      _leafSize(std::max(leafSize, static_cast<tIndex>(1))) {}
+
+  void setGravitationalConstant(const Real G) { _G = G; }
+  void setOpeningAngle(const Real theta) { _theta = theta; }
+  void setSoftening(const Real eps) { _eps2 = eps*eps; }
+  void setLeafSize(const tIndex n) { _leafSize = std::max(n, static_cast<tIndex>(1)); }
+
+  tIndex apply(
+    const std::vector<Body *> &bodies, const Real, const Real) override {
+    const tIndex n = this->targetCount(bodies);
+    if(n < 2) return 0;
+
+    // Gather positions and masses into flat arrays for the traversal, with
+    // positions relative to the cell of the first body, so that a cluster
+    // far from the origin keeps its precision
+    _pos.resize(n);
+    _mass.resize(n);
+    const GridCell ref = this->target(bodies, 0).cell;
+    parallelFor(0, n, [&](const tIndex i) {
+      const Body &b = this->target(bodies, i);
+      _pos[i] = b.positionFrom(ref);
+      _mass[i] = b.M;
+    });
+
+    build();
+
+    parallelFor(0, n, [&](const tIndex i) {
+      this->target(bodies, i).F += accelerationAt(i) * _mass[i];
+    }, 64);
+    return 0;
+  }
+
+private:
+  static const tIndex NONE = std::numeric_limits<tIndex>::max();
+  static const tIndex MAX_DEPTH = 32;
+
+  struct Node {
+    Pos center;        // Cell center
+    PosReal half;      // Half of the cell size
+    Pos com;           // Center of mass
+    Real mass;
+    tIndex first, count;  // Bodies of the cell in _order
+    tIndex child[8];   // NONE for empty octants; all NONE for leaves
+  };
+
+  static tIndex octant(const Pos &p, const Pos &c) {
+    return (p[0] > c[0] ? 1 : 0) | (p[1] > c[1] ? 2 : 0) | (p[2] > c[2] ? 4 : 0);
+  }
+  static Pos childCenter(const Pos &c, const PosReal half, const tIndex o) {
+    const PosReal h = half/2;
+    return Pos(c[0] + (o&1 ? h : -h), c[1] + (o&2 ? h : -h), c[2] + (o&4 ? h : -h));
+  }
+
+  // Sort _order[begin, end) by octant around c; off receives the 9 offsets
+  void partition(
+    const tIndex begin, const tIndex end, const Pos &c, tIndex off[9]) {
+    tIndex count[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+    for(tIndex k = begin; k < end; ++k)
+      ++count[octant(_pos[_order[k]], c)];
+    off[0] = begin;
+    for(tIndex o = 0; o < 8; ++o) off[o+1] = off[o] + count[o];
+
+    tIndex cursor[8];
+    std::copy(off, off + 8, cursor);
+    for(tIndex k = begin; k < end; ++k)
+      _tmp[cursor[octant(_pos[_order[k]], c)]++] = _order[k];
+    std::copy(_tmp.begin() + begin, _tmp.begin() + end, _order.begin() + begin);
+  }
+
+  // Serial recursive construction of the subtree of a cell into pool
+  tIndex buildNode(
+    std::vector<Node> &pool, const tIndex begin, const tIndex end,
+    const Pos &center, const PosReal half, const tIndex depth) {
+    const tIndex id = static_cast<tIndex>(pool.size());
+    pool.push_back(Node());
+    Node node;
+    node.center = center;
+    node.half = half;
+    node.first = begin;
+    node.count = end - begin;
+    for(tIndex &c : node.child) c = NONE;
+
+    if(node.count <= _leafSize || depth >= MAX_DEPTH) {
+      summarize(node);
+    } else {
+      tIndex off[9];
+      partition(begin, end, center, off);
+      node.mass = 0;
+      node.com = Pos(0);
+      for(tIndex o = 0; o < 8; ++o) {
+        if(off[o] == off[o+1]) continue;
+        node.child[o] = buildNode(
+          pool, off[o], off[o+1], childCenter(center, half, o), half/2, depth + 1);
+        const Node &c = pool[node.child[o]];
+        node.mass += c.mass;
+        node.com += c.com * static_cast<PosReal>(c.mass);
+      }
+      if(node.mass > 0) node.com /= static_cast<PosReal>(node.mass);
+    }
+    pool[id] = node;
+    return id;
+  }
+
+  void summarize(Node &node) const {
+    node.mass = 0;
+    node.com = Pos(0);
+    for(tIndex k = node.first; k < node.first + node.count; ++k) {
+      node.mass += _mass[_order[k]];
+      node.com += _pos[_order[k]] * _mass[_order[k]];
+    }
+    if(node.mass > 0) node.com /= node.mass;
+  }
+
+  // The root is split serially; its eight subtrees are built in parallel
+  // into separate pools, then appended to the node array.
+  void build() {
+    const tIndex n = static_cast<tIndex>(_pos.size());
+    _order.resize(n);
+    _tmp.resize(n);
+    for(tIndex i = 0; i < n; ++i) _order[i] = i;
+
+    Pos lo(_pos[0]), hi(_pos[0]);
+    for(const Pos &p : _pos) {
+      for(tIndex d = 0; d < 3; ++d) {
+        lo[d] = std::min(lo[d], p[d]);
+        hi[d] = std::max(hi[d], p[d]);
+      }
+    }
+
+    Node root;
+    root.center = (lo + hi) * static_cast<PosReal>(0.5);
+    root.half = std::max(std::max(hi[0] - lo[0], hi[1] - lo[1]), hi[2] - lo[2])/2;
+    root.half = std::max(root.half, std::numeric_limits<PosReal>::min());
+    root.first = 0;
+    root.count = n;
+    for(tIndex &c : root.child) c = NONE;
+
+    _nodes.clear();
+    if(n <= _leafSize) {
+      summarize(root);
+      _nodes.push_back(root);
+      return;
+    }
+
+    tIndex off[9];
+    partition(0, n, root.center, off);
+    parallelFor(0, 8, [&](const tIndex o) {
+      _pools[o].clear();
+      if(off[o] < off[o+1])
+        buildNode(_pools[o], off[o], off[o+1],
+                  childCenter(root.center, root.half, o), root.half/2, 1);
+    }, 1);
+
+    root.mass = 0;
+    root.com = Pos(0);
+    _nodes.push_back(root);
+    for(tIndex o = 0; o < 8; ++o) {
+      if(_pools[o].empty()) continue;
+      const tIndex base = static_cast<tIndex>(_nodes.size());
+      for(Node nd : _pools[o]) {
+        for(tIndex &c : nd.child)
+          if(c != NONE) c += base;
+        _nodes.push_back(nd);
+      }
+      Node &r = _nodes[0];
+      r.child[o] = base;
+      r.mass += _nodes[base].mass;
+      r.com += _nodes[base].com * static_cast<PosReal>(_nodes[base].mass);
+    }
+    if(_nodes[0].mass > 0) _nodes[0].com /= static_cast<PosReal>(_nodes[0].mass);
+  }
+
+  // Gravitational acceleration at body i
+  Vec accelerationAt(const tIndex i) const {
+    const Pos p = _pos[i];
+    const Real theta2 = _theta*_theta;
+    Vec a(0);
+
+    tIndex stack[8*MAX_DEPTH + 1];
+    tIndex top = 0;
+    stack[top++] = 0;
+    while(top) {
+      const Node &nd = _nodes[stack[--top]];
+      const Vec d = Vec(Pos(nd.com - p));
+      const Real r2 = d.lengthSquare();
+      const Real size = static_cast<Real>(2*nd.half);
+      const bool outside =
+        std::abs(p[0] - nd.center[0]) > nd.half ||
+        std::abs(p[1] - nd.center[1]) > nd.half ||
+        std::abs(p[2] - nd.center[2]) > nd.half;
+
+      if(outside && size*size < theta2*r2) {
+        // Far enough: the whole cell acts as a point mass
+        const Real s2 = r2 + _eps2;
+        a += d * (_G*nd.mass/(s2*std::sqrt(s2)));
+      } else if(nd.child[0] == NONE && nd.child[1] == NONE &&
+                nd.child[2] == NONE && nd.child[3] == NONE &&
+                nd.child[4] == NONE && nd.child[5] == NONE &&
+                nd.child[6] == NONE && nd.child[7] == NONE) {
+        // Leaf: direct sum
+        for(tIndex k = nd.first; k < nd.first + nd.count; ++k) {
+          const tIndex j = _order[k];
+          if(j == i) continue;
+          const Vec dj = Vec(Pos(_pos[j] - p));
+          const Real s2 = dj.lengthSquare() + _eps2;
+          a += dj * (_G*_mass[j]/(s2*std::sqrt(s2)));
+        }
+      } else {
+        for(tIndex o = 0; o < 8; ++o)
+          if(nd.child[o] != NONE) stack[top++] = nd.child[o];
+      }
+    }
+    return a;
+  }
+
+  Real _G;             // Gravitational constant
+  Real _theta;         // Opening angle
+  Real _eps2;          // Squared softening length
+  tIndex _leafSize;    // Maximum number of bodies in a leaf
+
+  std::vector<Pos> _pos;
+  std::vector<Real> _mass;
+  std::vector<tIndex> _order, _tmp;  // Body indices sorted by cell
+  std::vector<Node> _nodes;
+  std::vector<Node> _pools[8];       // Per-octant subtrees during the build
+};
+
+typedef BarnesHutGravityT<FloatPrecision> BarnesHutGravity;
+
+#endif  /* _BARNESHUT_HPP_ */
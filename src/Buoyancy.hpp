@@ -0,0 +1,211 @@
+// ----------------------------------------------------------------------------
+// Buoyancy.hpp
+//
+//  Created on: 18 Oct 2026
+//      Author: Kiwon Um
+//        Mail: kiwon.um@telecom-paris.fr
+//
+// Description: Buoyancy and hydrodynamic damping on closed hulls (DO NOT DISTRIBUTE!)
+//
+// Copyright 2020-2024 Kiwon Um
+//
+// The copyright to the computer program(s) herein is the property of Kiwon Um,
+// Telecom Paris, France. The program(s) may be used and/or copied only with
+// the written permission of Kiwon Um or in accordance with the terms and
+// conditions stipulated in the agreement/contract under which the program(s)
+// have been supplied.
+// ----------------------------------------------------------------------------
+
+#ifndef _BUOYANCY_HPP_
+#define _BUOYANCY_HPP_
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "ForceGenerators.hpp"
+#include "Mesh.h"
+
+// Archimedes' force on bodies crossing a water plane {x | n.x <= d}. The
+// submerged volume and its centroid come from the hull triangles clipped
+// against the plane: with the origin on the water surface, the waterline
+// cap contributes nothing, so the submerged volume is the sum of the signed
+// tetrahedra spanned by the origin and the clipped triangles. The hull must
+// be closed and wound outwards, expressed in body space.
+template<typename Policy>
+class BuoyancyT : public ForceGeneratorT<Policy> {
+public:
+  typedef typename Policy::Real Real;
+  typedef typename Policy::Vec Vec;
+  typedef typename Policy::PosReal PosReal;
+  typedef typename Policy::Pos Pos;
+  typedef BodyAttributesT<Policy> Body;
+
+  static const tIndex BATCH = 8;   // Triangles processed together
+
+  explicit BuoyancyT(
+    const Vec &up = Vec(0, 1, 0), const Real level = 0,
+    const Real density = 1000, const Real g = 9.8)
+    : _n(up.normalized()), _d(level), _rho(density), _g(g),
+      _current(0), _linDamping(1), _angDamping(0.1) {}
+
+  void setWaterPlane(const Vec &up, const Real level) {
+    _n = up.normalized();
+    _d = level;
+  }
+  void shiftOrigin(const Pos &delta) override { _d -= height(delta); }
+  void setDensity(const Real rho) { _rho = rho; }
+  void setGravity(const Real g) { _g = g; }
+  void setCurrent(const Vec &v) { _current = v; }
+  // Drag per unit of submerged mass of water on the relative velocity and
+  // on the angular velocity
+  void setDamping(const Real linear, const Real angular) {
+    _linDamping = linear;
+    _angDamping = angular;
+  }
+
+  // Build the hull table of the given body from its mesh
+  void addBody(const tIndex body, const Mesh &mesh) {
+    const std::vector<glm::vec3> &P = mesh.vertexPositions();
+    Hull h;
+    h.body = body;
+    for(const glm::uvec3 &t : mesh.triangleIndices())
+      h.push(P[t[0]], P[t[1]], P[t[2]]);
+    while(h.size() % BATCH)
+      h.push(glm::vec3(0), glm::vec3(0), glm::vec3(0));
+    h.straddle.resize(h.size());
+    _hulls.push_back(h);
+  }
+  void clearBodies() { _hulls.clear(); }
+
+  tIndex apply(
+    const std::vector<Body *> &bodies, const Real, const Real) override {
+    for(Hull &h : _hulls) {
+      Body &b = *bodies[h.body];
+
+      // Water plane in body space; o is the point of the surface closest to
+      // the center of mass, used as the origin of the tetrahedra.
+      const Vec n = b.toBody(_n);
+      const Real depth = static_cast<Real>(_d - height(this->position(b)));
+      const Vec o = n*depth;
+
+      Real vol;
+      Vec moment;
+      submerged(h, n, o, vol, moment);
+      if(vol <= 0) continue;
+
+      const Vec cb = b.toWorld(o + moment/vol);    // Center of buoyancy
+      const Real mw = _rho*vol;                   // Displaced mass
+      const Vec f = _n*(mw*_g) - (b.V + b.omega.crossProduct(cb) - _current)*(mw*_linDamping);
+      b.F += f;
+      b.tau += cb.crossProduct(f) - b.omega*(mw*_angDamping);
+    }
+    return 0;
+  }
+
+private:
+  // Height of a world position along the surface normal
+  PosReal height(const Pos &x) const {
+    return _n[0]*static_cast<PosReal>(x[0]) + _n[1]*static_cast<PosReal>(x[1]) +
+      _n[2]*static_cast<PosReal>(x[2]);
+  }
+
+  // Hull triangles a, b, c in structure-of-arrays layout, body space
+  struct Hull {
+    tIndex body;
+    std::vector<Real> ax, ay, az, bx, by, bz, cx, cy, cz;
+    std::vector<unsigned char> straddle;  // Crosses the surface, per triangle
+
+    void push(const glm::vec3 &a, const glm::vec3 &b, const glm::vec3 &c) {
+      ax.push_back(a.x); ay.push_back(a.y); az.push_back(a.z);
+      bx.push_back(b.x); by.push_back(b.y); bz.push_back(b.z);
+      cx.push_back(c.x); cy.push_back(c.y); cz.push_back(c.z);
+    }
+    std::size_t size() const { return ax.size(); }
+  };
+
+  // Submerged volume and its first moment relative to o. Fully submerged
+  // triangles, the bulk, go through a branch-free batched loop that also
+  // flags the triangles crossing the surface; only those few are clipped
+  // afterwards.
+  void submerged(
+    Hull &h, const Vec &n, const Vec &o, Real &vol, Vec &moment) const {
+    Real lv[BATCH] = {0}, lmx[BATCH] = {0}, lmy[BATCH] = {0}, lmz[BATCH] = {0};
+    const Real ox = o[0], oy = o[1], oz = o[2];
+    const Real nx = n[0], ny = n[1], nz = n[2];
+    const Real sixth = static_cast<Real>(1)/6, quarter = static_cast<Real>(0.25);
+
+    const std::size_t count = h.size();
+    for(std::size_t i0 = 0; i0 < count; i0 += BATCH) {
+      for(tIndex l = 0; l < BATCH; ++l) {
+        const std::size_t i = i0 + l;
+        // Vertices relative to o and their depths below the surface
+        const Real Ax = h.ax[i] - ox, Ay = h.ay[i] - oy, Az = h.az[i] - oz;
+        const Real Bx = h.bx[i] - ox, By = h.by[i] - oy, Bz = h.bz[i] - oz;
+        const Real Cx = h.cx[i] - ox, Cy = h.cy[i] - oy, Cz = h.cz[i] - oz;
+        const Real sa = -(nx*Ax + ny*Ay + nz*Az);
+        const Real sb = -(nx*Bx + ny*By + nz*Bz);
+        const Real sc = -(nx*Cx + ny*Cy + nz*Cz);
+
+        const bool full = (sa >= 0) & (sb >= 0) & (sc >= 0);
+        const bool none = (sa < 0) & (sb < 0) & (sc < 0);
+        h.straddle[i] = !full & !none;
+
+        const Real v = full ? sixth*(
+          Ax*(By*Cz - Bz*Cy) + Ay*(Bz*Cx - Bx*Cz) + Az*(Bx*Cy - By*Cx)) : 0;
+        lv[l] += v;
+        lmx[l] += v*quarter*(Ax + Bx + Cx);
+        lmy[l] += v*quarter*(Ay + By + Cy);
+        lmz[l] += v*quarter*(Az + Bz + Cz);
+      }
+    }
+
+    vol = 0;
+    moment = Vec(0);
+    for(tIndex l = 0; l < BATCH; ++l) {
+      vol += lv[l];
+      moment += Vec(lmx[l], lmy[l], lmz[l]);
+    }
+
+    for(std::size_t i = 0; i < count; ++i) {
+      if(!h.straddle[i]) continue;
+      const Vec p[3] = {
+        Vec(h.ax[i], h.ay[i], h.az[i]) - o,
+        Vec(h.bx[i], h.by[i], h.bz[i]) - o,
+        Vec(h.cx[i], h.cy[i], h.cz[i]) - o };
+      clipTriangle(p, n, vol, moment);
+    }
+  }
+
+  // Keep the part of triangle p below the surface through the origin and
+  // add the tetrahedra it spans with the origin.
+  static void clipTriangle(
+    const Vec p[3], const Vec &n, Real &vol, Vec &moment) {
+    Vec poly[4];
+    tIndex m = 0;
+    for(tIndex i = 0; i < 3; ++i) {
+      const tIndex j = (i + 1)%3;
+      const Real si = -n.dotProduct(p[i]), sj = -n.dotProduct(p[j]);
+      if(si >= 0) poly[m++] = p[i];
+      if((si >= 0) != (sj >= 0))
+        poly[m++] = p[i] + (p[j] - p[i])*(si/(si - sj));
+    }
+    for(tIndex k = 1; k + 1 < m; ++k) {
+      const Real v = poly[0].dotProduct(poly[k].crossProduct(poly[k+1]))/6;
+      vol += v;
+      moment += (poly[0] + poly[k] + poly[k+1])*(v/4);
+    }
+  }
+
+  Vec _n;            // Water surface normal, pointing out of the water
+  PosReal _d;        // Water level along _n
+  Real _rho;         // Water density
+  Real _g;           // Gravity magnitude
+  Vec _current;      // Water velocity
+  Real _linDamping, _angDamping;
+  std::vector<Hull> _hulls;
+};
+
+typedef BuoyancyT<FloatPrecision> Buoyancy;
+
+#endif  /* _BUOYANCY_HPP_ */
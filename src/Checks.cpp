@@ -0,0 +1,585 @@
+#include "Checks.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Aerodynamics.hpp"
+#include "BarnesHut.hpp"
+#include "Buoyancy.hpp"
+#include "FloatingOrigin.hpp"
+#include "MassProperties.hpp"
+#include "Mesh.h"
+#include "Parallel.hpp"
+#include "RigidSolver.hpp"
+
+namespace {
+
+int g_failures = 0;
+
+void report(const std::string &name, const bool ok, const std::string &detail)
+{
+  std::cout << "> [Check] " << name << (ok ? ": ok (" : ": FAILED (") << detail << ")" << std::endl;
+  if(!ok) ++g_failures;
+}
+
+// Many small loops back to back on a pool of its own, so that workers are
+// still leaving a loop when the next one starts, even on a single core:
+// every task of every loop must run exactly once
+void checkThreadPool()
+{
+  ThreadPool pool(4);
+  const int loops = 20000;
+  std::vector<std::atomic<int> > hits(64);
+  long runs = 0, expected = 0, wrong = 0;
+  for(int it = 0; it < loops; ++it) {
+    const tIndex n = 2 + (it*7919)%40;
+    for(std::atomic<int> &h : hits) h = 0;
+    pool.run(n, [&hits](const tIndex k) { ++hits[k]; });
+    for(tIndex k = 0; k < hits.size(); ++k) {
+      runs += hits[k];
+      if(hits[k] != (k < n ? 1 : 0)) ++wrong;
+    }
+    expected += n;
+  }
+  std::ostringstream s;
+  s << loops << " loops, " << runs << " task runs for " << expected << " tasks, "
+    << wrong << " run other than once";
+  report("Thread pool back-to-back loops", runs == expected && !wrong, s.str());
+}
+
+// Barnes-Hut against the direct O(n^2) sum on a random cluster: exact with
+// theta = 0, within a few percent with the default opening angle
+void checkBarnesHut()
+{
+  const tIndex n = 2000;
+  const tReal G = 1, eps = 1e-2;
+  std::mt19937 rng(7);
+  std::uniform_real_distribution<tReal> pos(-1, 1), mass(1, 2);
+  std::vector<BodyAttributes> storage(n);
+  std::vector<BodyAttributes *> bodies(n);
+  for(tIndex i = 0; i < n; ++i) {
+    storage[i].X = Vec3f(pos(rng), pos(rng), pos(rng));
+    storage[i].M = mass(rng);
+    bodies[i] = &storage[i];
+  }
+
+  std::vector<Vec3f> direct(n, Vec3f(0));
+  for(tIndex i = 0; i < n; ++i) {
+    for(tIndex j = 0; j < n; ++j) {
+      if(i == j) continue;
+      const Vec3f d = storage[j].X - storage[i].X;
+      const tReal s2 = d.lengthSquare() + eps*eps;
+      direct[i] += d*(G*storage[i].M*storage[j].M/(s2*std::sqrt(s2)));
+    }
+  }
+
+  const tReal thetas[2] = {0, 0.5};
+  const tReal bounds[2] = {1e-4, 5e-2};
+  for(int k = 0; k < 2; ++k) {
+    BarnesHutGravity gravity(G, thetas[k], eps);
+    for(BodyAttributes &b : storage) b.F = Vec3f(0);
+    gravity.apply(bodies, 0, 0);
+    tReal err2 = 0, ref2 = 0;
+    for(tIndex i = 0; i < n; ++i) {
+      err2 += (storage[i].F - direct[i]).lengthSquare();
+      ref2 += direct[i].lengthSquare();
+    }
+    const tReal rel = std::sqrt(err2/ref2);
+    std::ostringstream s;
+    s << "relative RMS error " << rel << " < " << bounds[k];
+    report(std::string("Barnes-Hut theta=") + (k ? "0.5" : "0"), rel < bounds[k], s.str());
+  }
+}
+
+// A box at rest in a uniform wind: only the upwind face is pushed, by the
+// flat-plate drag 1/2 rho A Cd W^2 along the wind, with no lift and no
+// torque. Turning the box a quarter turn about y exposes the broad face.
+void checkAerodynamics()
+{
+  const tReal w = 2, h = 1, d = 0.5, W = 10, rho = 1.225, Cd = 1;
+  Mesh mesh;
+  mesh.addBox(w, h, d);
+  AerodynamicForces aero(Vec3f(W, 0, 0), rho);
+  aero.addBody(0, mesh, Cd, 0.5);
+
+  const tReal areas[2] = {h*d, w*h};
+  for(int k = 0; k < 2; ++k) {
+    BodyAttributes b;
+    if(k) b.q = BodyAttributes::Quat(std::sqrt(0.5f), 0, std::sqrt(0.5f), 0);
+    b.F = b.tau = Vec3f(0);
+    std::vector<BodyAttributes *> bodies(1, &b);
+    aero.apply(bodies, 0, 0);
+
+    const Vec3f expected(static_cast<tReal>(0.5)*rho*areas[k]*Cd*W*W, 0, 0);
+    const tReal err = (b.F - expected).length()/expected.length();
+    const tReal torque = b.tau.length();
+    std::ostringstream s;
+    s << "F = " << b.F << ", expected " << expected << ", |tau| = " << torque;
+    report(k ? "Aerodynamics broad face" : "Aerodynamics narrow face",
+           err < 1e-4 && torque < 1e-3*expected.length(), s.str());
+  }
+}
+
+// A unit cube of half the density of water, dropped from above the
+// surface, must come to rest with half its volume submerged. Upright is not
+// stable at this density: the cube tips over to float edge up, but being
+// centrally symmetric it still floats with its center on the surface.
+void checkBuoyancy()
+{
+  const tReal g = 9.8, rho = 1000, dt = 0.005;
+  Mesh mesh;
+  mesh.addBox(1, 1, 1);
+  Box cube(1, 1, 1, rho/2);
+  cube.X = Vec3f(0, 1, 0);
+
+  RigidSolver solver(&cube, Vec3f(0, -g, 0));
+  solver.setVerbose(false);
+  std::shared_ptr<Buoyancy> water = std::make_shared<Buoyancy>(Vec3f(0, 1, 0), 0, rho, g);
+  water->addBody(0, mesh);
+  solver.addForceGenerator(water);
+  for(int i = 0; i < 8000; ++i) solver.step(dt);
+
+  const tReal depth = -cube.X[1];
+  const tReal tilt = 2*std::acos(std::min(std::abs(cube.q.w), 1.f))*180/static_cast<tReal>(M_PI);
+  std::ostringstream s;
+  s << "center " << depth << " below the surface after 40 s, tilt " << tilt
+    << " deg, |V| = " << cube.V.length();
+  report("Buoyancy half-density cube",
+         std::abs(depth) < 1e-3 && cube.V.length() < 1e-3, s.str());
+}
+
+// A box mesh off the origin against the analytic box: same mass, the
+// center of mass at the offset, the same inertia tensor about it, and the
+// same principal moments, up to their order
+void checkMassProperties()
+{
+  const tReal w = 2, h = 1, d = 0.5, dens = 10;
+  const Vec3f offset(1, 2, 3);
+  Mesh mesh;
+  mesh.addBox(w, h, d);
+  for(glm::vec3 &p : mesh.vertexPositions()) p += glm::vec3(offset[0], offset[1], offset[2]);
+
+  const MeshBody body(mesh, dens);
+  const Box box(w, h, d, dens);
+
+  tReal err = std::abs(body.M - box.M)/box.M;
+  err = std::max(err, (body.X - offset).length());
+  const tReal ref = std::max(box.I0diag[0], std::max(box.I0diag[1], box.I0diag[2]));
+  for(tIndex i = 0; i < 3; ++i)
+    for(tIndex j = 0; j < 3; ++j)
+      err = std::max(err, std::abs(body.props.inertia(i, j) - box.I0(i, j))/ref);
+  tReal a[3] = {body.I0diag[0], body.I0diag[1], body.I0diag[2]};
+  tReal b[3] = {box.I0diag[0], box.I0diag[1], box.I0diag[2]};
+  std::sort(a, a + 3);
+  std::sort(b, b + 3);
+  for(tIndex i = 0; i < 3; ++i) err = std::max(err, std::abs(a[i] - b[i])/ref);
+
+  std::ostringstream s;
+  s << "M = " << body.M << " (box " << box.M << "), principal moments "
+    << a[0] << " " << a[1] << " " << a[2] << " (box " << b[0] << " " << b[1] << " " << b[2]
+    << "), max relative error " << err;
+  report("Mass properties of a box mesh", err < 1e-5, s.str());
+}
+
+// Per-body grid cells. A body 10,000 km out drifting at 1 cm/s moves
+// exactly like its twin at the origin, where a plain float position, spaced
+// by 1 m there, does not move at all. A body crossing into the next cell
+// moves to it with its offset to a neighbor left in the old cell intact.
+// Rebasing the solver frame onto the far body moves no body.
+void checkFloatingOrigin()
+{
+  const tReal dt = 0.01f, speed = 1e-2f;
+  const int steps = 1000;
+  Box far, twin, a, b;
+  WorldPosition start;
+  start.cell = GridCell(9765, 0, -2930);   // About (1e7, 0, -3e6) m
+  start.local = Vec3f(0.25f, 10, -0.5f);
+  FloatingOrigin::place(far, start);
+  twin.X = start.local;
+  far.V = twin.V = Vec3f(speed, 0, 0);
+  far.P = twin.P = far.V*far.M;
+  const tReal plain0 = static_cast<tReal>(start.cell.x*GridCell::size() + start.local[0]);
+  tReal plain = plain0;
+
+  // a walks out of the origin cell across +x, b stays behind
+  a.X = Vec3f(511.5f, 0, 0);
+  a.V = Vec3f(100, 0, 0);
+  a.P = a.V*a.M;
+  b.X = Vec3f(505, 2, 0);
+
+  RigidSolver solver(&far);
+  solver.setVerbose(false);
+  solver.addBody(&twin);
+  solver.addBody(&a);
+  solver.addBody(&b);
+  for(int i = 0; i < steps; ++i) {
+    solver.step(dt);
+    plain += speed*dt;
+  }
+
+  const tReal moved = far.X[0] - start.local[0];
+  const bool sameAsTwin = far.cell == start.cell && (far.X - twin.X).length() == 0;
+  const tReal offsetErr = (a.offsetTo(b) - Vec3f(505 - (511.5f + 100*dt*steps), 2, 0)).length();
+
+  FloatingOrigin origin(&solver);
+  const WorldPosition before = origin.bodyPosition(far);
+  const bool rebased = origin.update(far);
+  const WorldPosition after = origin.bodyPosition(far);
+  const Vec3f local = origin.localPosition(after);
+  const WorldPosition back = origin.worldPosition(local);
+
+  std::ostringstream s;
+  s << "far body moved " << moved << " m for " << speed*dt*steps << ", as its twin: "
+    << sameAsTwin << " (plain float: " << plain - plain0 << " m), walker in cell "
+    << a.cell.x << " with offset error " << offsetErr << ", after rebase "
+    << local.length() << " m from the origin";
+  report("Floating origin per-body cells",
+         sameAsTwin && std::abs(moved - speed*dt*steps) < 1e-4 &&
+         a.cell.x == 1 && std::abs(a.X[0]) <= 512 && offsetErr < 1e-3 &&
+         rebased && before.cell == after.cell && (before.local - after.local).length() == 0 &&
+         local.length() < 1024 && back.cell == after.cell &&
+         (back.local - after.local).length() == 0, s.str());
+}
+
+// Residual |A v - l v|, orthonormality |V^T V - I| and order of the
+// eigen-decomposition of A (upper triangle a), relative to the size of A
+template<typename T>
+void eigenErrors(
+  const T a[6], const T l[3], const T V[9], T &residual, T &orthogonality, bool &sorted)
+{
+  const T A[3][3] = {{a[0], a[1], a[2]}, {a[1], a[3], a[4]}, {a[2], a[4], a[5]}};
+  T norm = 0;
+  for(int i = 0; i < 3; ++i)
+    for(int j = 0; j < 3; ++j) norm = std::max(norm, std::abs(A[i][j]));
+  norm = std::max(norm, std::numeric_limits<T>::min());
+  for(int k = 0; k < 3; ++k) {
+    for(int i = 0; i < 3; ++i) {
+      T r = -l[k]*V[3*i + k];
+      for(int j = 0; j < 3; ++j) r += A[i][j]*V[3*j + k];
+      residual = std::max(residual, std::abs(r)/norm);
+    }
+    for(int m = 0; m < 3; ++m) {
+      T d = (k == m) ? -1 : 0;
+      for(int i = 0; i < 3; ++i) d += V[3*i + k]*V[3*i + m];
+      orthogonality = std::max(orthogonality, std::abs(d));
+    }
+  }
+  sorted = sorted && l[0] >= l[1] && l[1] >= l[2];
+}
+
+// Random symmetric matrices, plus the hard cases: repeated eigenvalues,
+// diagonal, rank one and zero. The batched solver, over a count that is not
+// a multiple of its lane width, must agree with the single one.
+template<typename T>
+void checkSymmetricEigen(const char *name, const T bound)
+{
+  std::mt19937 rng(11);
+  std::uniform_real_distribution<T> u(-10, 10);
+  std::vector<std::array<T, 6> > mats;
+  for(int i = 0; i < 1000; ++i) {
+    std::array<T, 6> a;
+    for(T &x : a) x = u(rng);
+    mats.push_back(a);
+  }
+  const std::array<T, 6> special[5] = {
+    {{2, 0, 0, 2, 0, 2}}, {{3, 0, 0, 1, 0, 2}}, {{1, 1, 1, 1, 1, 1}},
+    {{0, 0, 0, 0, 0, 0}}, {{2, 1, 0, 2, 0, 5}} };
+  mats.insert(mats.end(), special, special + 5);
+
+  const std::size_t n = mats.size();
+  T residual = 0, orthogonality = 0, mismatch = 0;
+  bool sorted = true;
+  std::vector<T> soa[18];
+  for(std::vector<T> &v : soa) v.resize(n);
+  for(std::size_t i = 0; i < n; ++i) {
+    const std::array<T, 6> &a = mats[i];
+    const Matrix3x3<T> A(a[0], a[1], a[2], a[1], a[3], a[4], a[2], a[4], a[5]);
+    Vector3<T> l;
+    Matrix3x3<T> V;
+    A.symmetricEigen(l, V);
+    const T lv[3] = {l.x, l.y, l.z};
+    eigenErrors(a.data(), lv, V.v1, residual, orthogonality, sorted);
+    for(int k = 0; k < 6; ++k) soa[k][i] = a[k];
+    for(int k = 0; k < 3; ++k) soa[6 + k][i] = lv[k];
+  }
+
+  const T *in[6];
+  T *values[3], *vectors[9];
+  std::vector<T> outValues[3], outVectors[9];
+  for(int k = 0; k < 6; ++k) in[k] = soa[k].data();
+  for(int k = 0; k < 3; ++k) { outValues[k].resize(n); values[k] = outValues[k].data(); }
+  for(int k = 0; k < 9; ++k) { outVectors[k].resize(n); vectors[k] = outVectors[k].data(); }
+  symmetricEigenBatch(n, in, values, vectors);
+  for(std::size_t i = 0; i < n; ++i) {
+    const T l[3] = {values[0][i], values[1][i], values[2][i]};
+    T V[9];
+    for(int k = 0; k < 9; ++k) V[k] = vectors[k][i];
+    eigenErrors(mats[i].data(), l, V, residual, orthogonality, sorted);
+    for(int k = 0; k < 3; ++k)
+      mismatch = std::max(mismatch, std::abs(l[k] - soa[6 + k][i])/static_cast<T>(10));
+  }
+
+  std::ostringstream s;
+  s << n << " matrices, residual " << residual << ", orthogonality " << orthogonality
+    << ", batch mismatch " << mismatch << (sorted ? ", sorted" : ", NOT sorted");
+  report(std::string("Symmetric eigen-decomposition ") + name,
+         residual < bound && orthogonality < bound && mismatch < bound && sorted, s.str());
+}
+
+// Kinetic energy and world angular momentum of a body
+void rotationalInvariants(const BodyAttributes &b, tReal &energy, Vec3f &momentum)
+{
+  const Vec3f w = b.toBody(b.omega);
+  momentum = b.toWorld(b.I0diag*w);
+  energy = static_cast<tReal>(0.5)*w.dotProduct(b.I0diag*w);
+}
+
+// A thin plate spun near its unstable middle axis tumbles. Over a minute at
+// 60 Hz the implicit gyroscopic step must keep its energy and the magnitude
+// of its angular momentum, where the explicit step gains energy many times
+// over; the direction of L drifts slowly with the first-order orientation
+// update.
+void checkGyroscopic()
+{
+  const tReal dt = 1.f/60;
+  const int steps = 3600;
+  tReal energy[2], magnitude[2], direction[2];
+  for(int implicit = 0; implicit < 2; ++implicit) {
+    Box plate(1, 0.4f, 0.05f, 10, Vec3f(0), Vec3f(0.1f, 5, 0.1f));
+    RigidSolver solver(&plate);
+    solver.setVerbose(false);
+    solver.setImplicitGyroscopic(implicit != 0);
+    tReal e0, e = 0;
+    Vec3f l0, l;
+    rotationalInvariants(plate, e0, l0);
+    energy[implicit] = magnitude[implicit] = 0;
+    for(int i = 0; i < steps; ++i) {
+      solver.step(dt);
+      rotationalInvariants(plate, e, l);
+      energy[implicit] = std::max(energy[implicit], std::abs(e - e0)/e0);
+      magnitude[implicit] = std::max(magnitude[implicit], std::abs(l.length() - l0.length())/l0.length());
+    }
+    direction[implicit] = (l - l0).length()/l0.length();
+  }
+  std::ostringstream s;
+  s << "60 s at 60 Hz, implicit: energy drift " << energy[1] << ", |L| drift " << magnitude[1]
+    << ", L drift " << direction[1] << "; explicit: " << energy[0] << ", " << magnitude[0]
+    << ", " << direction[0];
+  report("Implicit gyroscopic step",
+         energy[1] < 1e-3 && magnitude[1] < 1e-3 && direction[1] < 0.05, s.str());
+}
+
+// A small box thrown at 200 m/s against the floor moves 17 times its size
+// per step at 60 Hz; it must bounce off instead of tunnelling through
+void checkContinuousCollision()
+{
+  const tReal dt = 1.f/60;
+  Box box(0.2f, 0.2f, 0.2f, 10, Vec3f(3, -200, 0), Vec3f(5, 0, 3));
+  box.X = Vec3f(0, 5, 0);
+  RigidSolver solver(&box);
+  solver.setVerbose(false);
+  solver.addStaticPlane(Vec3f(0, 1, 0), Vec3f(0, 0, 0));
+  tReal lowest = box.X[1];
+  for(int i = 0; i < 60; ++i) {
+    solver.step(dt);
+    const Mat3f R = box.rotation();
+    for(const Vec3f &v : box.vdata0) lowest = std::min(lowest, box.X[1] + (R*v)[1]);
+  }
+  std::ostringstream s;
+  s << "lowest vertex " << lowest << " m, final height " << box.X[1]
+    << " m, vertical speed " << box.V[1] << " m/s, " << solver.eventCount() << " impacts";
+  report("Continuous collision at 200 m/s", lowest > -0.02f && box.X[1] > 0 &&
+         solver.eventCount() > 0, s.str());
+}
+
+// ---------------------------------------------------------------------------
+// Loader round-trips: the same box written in every supported format must
+// load back as the same triangles
+
+typedef std::array<float, 9> Triangle;
+
+const float BOX_X[2] = {-0.5f, 0.75f}, BOX_Y[2] = {-0.25f, 1.5f}, BOX_Z[2] = {-1, 0.5f};
+// Vertex i is at (BOX_X[i&1], BOX_Y[(i>>1)&1], BOX_Z[i>>2]); outward quads
+const unsigned int BOX_QUADS[6][4] = {
+  {0, 4, 6, 2}, {1, 3, 7, 5}, {0, 1, 5, 4}, {2, 6, 7, 3}, {0, 2, 3, 1}, {4, 5, 7, 6} };
+
+glm::vec3 boxVertex(const unsigned int i)
+{
+  return glm::vec3(BOX_X[i & 1], BOX_Y[(i >> 1) & 1], BOX_Z[i >> 2]);
+}
+
+// Triangles as vertex positions, each starting at its smallest vertex so
+// that the winding is kept, sorted
+std::vector<Triangle> canonicalTriangles(
+  const std::vector<glm::vec3> &P, const std::vector<glm::uvec3> &T)
+{
+  std::vector<Triangle> out;
+  for(const glm::uvec3 &t : T) {
+    std::array<std::array<float, 3>, 3> v;
+    for(int k = 0; k < 3; ++k) {
+      if(t[k] >= P.size()) return std::vector<Triangle>();
+      v[k] = {{P[t[k]].x, P[t[k]].y, P[t[k]].z}};
+    }
+    const int m = static_cast<int>(std::min_element(v.begin(), v.end()) - v.begin());
+    Triangle tri;
+    for(int k = 0; k < 3; ++k)
+      for(int d = 0; d < 3; ++d) tri[3*k + d] = v[(m + k)%3][d];
+    out.push_back(tri);
+  }
+  std::sort(out.begin(), out.end());
+  return out;
+}
+
+std::vector<Triangle> boxTriangles()
+{
+  std::vector<glm::vec3> P;
+  std::vector<glm::uvec3> T;
+  for(unsigned int i = 0; i < 8; ++i) P.push_back(boxVertex(i));
+  for(const unsigned int *q : BOX_QUADS) {
+    T.push_back(glm::uvec3(q[0], q[1], q[2]));
+    T.push_back(glm::uvec3(q[0], q[2], q[3]));
+  }
+  return canonicalTriangles(P, T);
+}
+
+// Binary scalar in the given byte order
+template<typename T>
+void putBinary(std::string &out, const T x, const bool bigEndian)
+{
+  const std::uint16_t probe = 1;
+  const bool hostBig = (*reinterpret_cast<const unsigned char *>(&probe) == 0);
+  char b[sizeof(T)];
+  std::memcpy(b, &x, sizeof(T));
+  if(bigEndian != hostBig) std::reverse(b, b + sizeof(T));
+  out.append(b, sizeof(T));
+}
+
+std::string plyFile(const std::string &format, const bool triangles, const bool extra)
+{
+  std::ostringstream h;
+  h << "ply\nformat " << format << " 1.0\ncomment RigidSim check\nelement vertex 8\n"
+    << "property float x\nproperty float y\nproperty float z\n"
+    << (extra ? "property uchar flag\n" : "")
+    << "element face " << (triangles ? 12 : 6) << "\n"
+    << "property list uchar int vertex_indices\nend_header\n";
+  std::string out = h.str();
+  const bool ascii = (format == "ascii"), big = (format == "binary_big_endian");
+  std::ostringstream body;
+  for(unsigned int i = 0; i < 8; ++i) {
+    const glm::vec3 p = boxVertex(i);
+    if(ascii) {
+      body << p.x << " " << p.y << " " << p.z << (extra ? " 7" : "") << "\n";
+    } else {
+      for(int d = 0; d < 3; ++d) putBinary(out, p[d], big);
+      if(extra) putBinary(out, static_cast<unsigned char>(7), big);
+    }
+  }
+  for(const unsigned int *q : BOX_QUADS) {
+    const unsigned int faces[2][4] = {{q[0], q[1], q[2], 0}, {q[0], q[2], q[3], 0}};
+    for(int f = 0; f < (triangles ? 2 : 1); ++f) {
+      const unsigned int *v = triangles ? faces[f] : q;
+      const int k = triangles ? 3 : 4;
+      if(ascii) {
+        body << k;
+        for(int j = 0; j < k; ++j) body << " " << v[j];
+        body << "\n";
+      } else {
+        putBinary(out, static_cast<unsigned char>(k), big);
+        for(int j = 0; j < k; ++j) putBinary(out, static_cast<std::int32_t>(v[j]), big);
+      }
+    }
+  }
+  return out + body.str();
+}
+
+void checkLoaders()
+{
+  std::ostringstream off, obj, objNeg;
+  off << "OFF\n# box\n8 6 0\n";
+  for(unsigned int i = 0; i < 8; ++i) {
+    const glm::vec3 p = boxVertex(i);
+    off << p.x << " " << p.y << " " << p.z << "\n";
+    obj << "v " << p.x << " " << p.y << " " << p.z << "\n";
+  }
+  objNeg << obj.str() << "vt 0 0\nvt 1 0\nvt 1 1\nvt 0 1\n";
+  for(const unsigned int *q : BOX_QUADS) {
+    off << "4 " << q[0] << " " << q[1] << " " << q[2] << " " << q[3] << "\n";
+    obj << "f " << q[0] + 1 << " " << q[1] + 1 << " " << q[2] + 1 << " " << q[3] + 1 << "\n";
+    // Negative indices count back from the last vertex read so far
+    objNeg << "f";
+    for(int k = 0; k < 4; ++k)
+      objNeg << " " << static_cast<int>(q[k]) - 8 << "/" << k - 4;
+    objNeg << "\n";
+  }
+
+  struct Case { const char *name, *file; std::string content; };
+  const Case cases[] = {
+    {"OFF", "rigidsim-check.off", off.str()},
+    {"OBJ", "rigidsim-check.obj", obj.str()},
+    {"OBJ negative indices", "rigidsim-check-neg.obj", objNeg.str()},
+    {"PLY ascii", "rigidsim-check-ascii.ply", plyFile("ascii", false, true)},
+    {"PLY binary little endian", "rigidsim-check-le.ply", plyFile("binary_little_endian", true, false)},
+    {"PLY binary big endian", "rigidsim-check-be.ply", plyFile("binary_big_endian", false, true)} };
+
+  const std::vector<Triangle> expected = boxTriangles();
+  std::shared_ptr<Mesh> mesh = std::make_shared<Mesh>(), cached = std::make_shared<Mesh>();
+  const std::string cacheFile = "rigidsim-check.rsm";
+  for(const Case &c : cases) {
+    std::string detail;
+    bool ok = false;
+    try {
+      {
+        std::ofstream f(c.file, std::ios::binary);
+        f << c.content;
+      }
+      loadMesh(c.file, mesh);
+      const std::vector<Triangle> got = canonicalTriangles(
+        mesh->vertexPositions(), mesh->triangleIndices());
+      writeMeshCache(*mesh, cacheFile);
+      loadMeshCache(cacheFile, cached);
+      const bool sameCache = canonicalTriangles(
+        cached->vertexPositions(), cached->triangleIndices()) == got;
+      ok = got == expected && mesh->vertexPositions().size() >= 8 && sameCache;
+      std::ostringstream s;
+      s << mesh->vertexPositions().size() << " vertices, " << mesh->triangleIndices().size()
+        << " triangles, " << (got == expected ? "same" : "DIFFERENT") << " triangles, cache "
+        << (sameCache ? "identical" : "DIFFERENT");
+      detail = s.str();
+    } catch(const std::exception &e) {
+      detail = e.what();
+    }
+    std::remove(c.file);
+    report(std::string("Load ") + c.name, ok, detail);
+  }
+  std::remove(cacheFile.c_str());
+}
+
+}  // namespace
+
+int runChecks()
+{
+  g_failures = 0;
+  checkThreadPool();
+  checkBarnesHut();
+  checkAerodynamics();
+  checkBuoyancy();
+  checkMassProperties();
+  checkFloatingOrigin();
+  checkSymmetricEigen<float>("(float)", 1e-5f);
+  checkSymmetricEigen<double>("(double)", 1e-13);
+  checkGyroscopic();
+  checkContinuousCollision();
+  checkLoaders();
+  return g_failures;
+}
@@ -0,0 +1,9 @@
+#ifndef CHECKS_H
+#define CHECKS_H
+
+// Headless checks of the physics against known answers, run by
+// `tpRigid --check` and by ctest. Prints one line per check and returns the
+// number of failures.
+int runChecks();
+
+#endif  // CHECKS_H
@@ -0,0 +1,123 @@
+// ----------------------------------------------------------------------------
+// FloatingOrigin.hpp
+//
+//  Created on: 18 Oct 2026
+//      Author: Kiwon Um
+//        Mail: kiwon.um@telecom-paris.fr
+//
+// Description: Floating origin for large worlds (DO NOT DISTRIBUTE!)
+//
+// Copyright 2020-2024 Kiwon Um
+//
+// The copyright to the computer program(s) herein is the property of Kiwon Um,
+// Telecom Paris, France. The program(s) may be used and/or copied only with
+// the written permission of Kiwon Um or in accordance with the terms and
+// conditions stipulated in the agreement/contract under which the program(s)
+// have been supplied.
+// ----------------------------------------------------------------------------
+
+#ifndef _FLOATINGORIGIN_HPP_
+#define _FLOATINGORIGIN_HPP_
+
+#include <cmath>
+#include <cstdint>
+
+#include "RigidSolver.hpp"
+
+// Position in an unbounded world: a grid cell and an offset from its center
+template<typename Policy>
+struct WorldPositionT {
+  GridCell cell;
+  typename Policy::Pos local;
+};
+
+// Large worlds on float positions. Every body stores its own grid cell and
+// its position X relative to the center of that cell (see GridCell), and
+// moves to the neighboring cell by itself when it leaves its own during a
+// step; offsets between bodies take the cell difference in integers first.
+// A body thus keeps the accuracy of float positions near the origin
+// wherever it is, with no double positions.
+//
+// What remains is the simulation frame of the solver: static planes and
+// the world positions held by force generators, e.g., spring anchors, are
+// relative to the solver's origin cell, as is the rendering. This class
+// keeps that frame on the active region: whenever the focus, e.g., the
+// player or the camera, gets further than the active radius from the
+// origin, the origin jumps to the focus cell and the frame is rebased.
+// Bodies are not touched by a rebase.
+template<typename Policy>
+class FloatingOriginT {
+public:
+  typedef typename Policy::PosReal PosReal;
+  typedef typename Policy::Pos Pos;
+  typedef RigidSolverT<Policy> Solver;
+  typedef BodyAttributesT<Policy> Body;
+  typedef WorldPositionT<Policy> WorldPosition;
+
+  explicit FloatingOriginT(Solver *solver = nullptr, const double radius = 0)
+    : _solver(solver), _radius(radius > 0 ? radius : GridCell::size()), _rebases(0) {}
+
+  void setSolver(Solver *solver) { _solver = solver; }
+  // Distance from the origin, along any axis, beyond which the focus
+  // triggers a rebase
+  void setActiveRadius(const double r) { _radius = r; }
+  double cellSize() const { return GridCell::size(); }
+
+  const GridCell& origin() const { return _solver->origin(); }
+  tIndex rebaseCount() const { return _rebases; }
+
+  // Rebase around the focus when it left the active region. Call between
+  // steps. Returns whether the origin moved.
+  bool update(const WorldPosition &focus) {
+    const Pos x = localPosition(focus);
+    if(std::abs(x[0]) <= _radius && std::abs(x[1]) <= _radius &&
+       std::abs(x[2]) <= _radius)
+      return false;
+
+    const GridCell &o = origin();
+    const GridCell cell(o.x + GridCell::steps(x[0]), o.y + GridCell::steps(x[1]),
+                        o.z + GridCell::steps(x[2]));
+    if(cell == o) return false;
+    _solver->setOrigin(cell);
+    ++_rebases;
+    return true;
+  }
+  bool update(const Body &focus) { return update(bodyPosition(focus)); }
+
+  // Conversions between the simulation frame and world positions
+  WorldPosition worldPosition(const Pos &x) const {
+    const GridCell &o = origin();
+    const GridCell k(GridCell::steps(x[0]), GridCell::steps(x[1]), GridCell::steps(x[2]));
+    WorldPosition p;
+    p.cell = GridCell(o.x + k.x, o.y + k.y, o.z + k.z);
+    p.local = x - cellOffset<PosReal>(GridCell(), k);
+    return p;
+  }
+  Pos localPosition(const WorldPosition &p) const {
+    return p.local + cellOffset<PosReal>(origin(), p.cell);
+  }
+
+  static WorldPosition bodyPosition(const Body &b) {
+    WorldPosition p;
+    p.cell = b.cell;
+    p.local = b.X;
+    return p;
+  }
+  WorldPosition bodyPosition(const tIndex i) const { return bodyPosition(*_solver->body(i)); }
+  // Put a body at a world position, e.g., when spawning it
+  static void place(Body &b, const WorldPosition &p) {
+    b.cell = p.cell;
+    b.X = p.local;
+    b.updateCell();
+  }
+
+private:
+  Solver *_solver;
+  double _radius;
+  tIndex _rebases;
+};
+
+typedef WorldPositionT<FloatPrecision> WorldPosition;
+typedef FloatingOriginT<FloatPrecision> FloatingOrigin;
+
+#endif  /* _FLOATINGORIGIN_HPP_ */
@@ -0,0 +1,300 @@
+// ----------------------------------------------------------------------------
+// ForceGenerators.hpp
+//
+//  Created on: 18 Oct 2026
+//      Author: Kiwon Um
+//        Mail: kiwon.um@telecom-paris.fr
+//
+// Description: Force generators for the rigid body solver (DO NOT DISTRIBUTE!)
+//
+// Copyright 2020-2024 Kiwon Um
+//
+// The copyright to the computer program(s) herein is the property of Kiwon Um,
+// Telecom Paris, France. The program(s) may be used and/or copied only with
+// the written permission of Kiwon Um or in accordance with the terms and
+// conditions stipulated in the agreement/contract under which the program(s)
+// have been supplied.
+// ----------------------------------------------------------------------------
+
+#ifndef _FORCEGENERATORS_HPP_
+#define _FORCEGENERATORS_HPP_
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "RigidBody.hpp"
+
+// A force generator accumulates forces and torques into the F and tau of the
+// bodies it affects. The solver calls apply() once per generator and step;
+// each generator then processes all its bodies in a single loop, so there
+// is one virtual call per generator instead of one per body. The batching
+// is per generator only: bodies stay separate objects reached through
+// pointers, so these loops are scalar. The simple generators do a few
+// flops per body, about what gathering M, V and X into arrays and
+// scattering F and tau back would cost; generators with real per-body
+// work (aerodynamics, buoyancy) keep their own structure-of-arrays data.
+template<typename Policy>
+class ForceGeneratorT {
+public:
+  typedef typename Policy::Real Real;
+  typedef BodyAttributesT<Policy> Body;
+
+  virtual ~ForceGeneratorT() {}
+
+  // Accumulate forces for the step [t, t+dt]. Returns the number of
+  // impulsive events generated during the step.
+  virtual tIndex apply(
+    const std::vector<Body *> &bodies, const Real t, const Real dt) = 0;
+
+  // World positions held by the generator are relative to the center of
+  // its origin cell, the one of the solver frame. Moving the origin
+  // re-expresses them through shiftOrigin(), unless reexpress is false,
+  // e.g., when the positions were given in the new frame already.
+  const GridCell& origin() const { return _origin; }
+  void setOrigin(const GridCell &origin, const bool reexpress = true) {
+    if(reexpress)
+      shiftOrigin(cellOffset<typename Policy::PosReal>(_origin, origin));
+    _origin = origin;
+  }
+
+  // The simulation frame moved to the point delta of the previous frame;
+  // generators holding world positions re-express them (default: none).
+  virtual void shiftOrigin(const typename Policy::Pos &) {}
+
+  // Restrict the generator to the given body indices (default: all bodies)
+  void setTargets(const std::vector<tIndex> &targets) { _targets = targets; }
+  const std::vector<tIndex>& targets() const { return _targets; }
+
+protected:
+  tIndex targetCount(const std::vector<Body *> &bodies) const {
+    return _targets.empty() ? static_cast<tIndex>(bodies.size()) :
+      static_cast<tIndex>(_targets.size());
+  }
+  Body& target(const std::vector<Body *> &bodies, const tIndex i) const {
+    return *bodies[_targets.empty() ? i : _targets[i]];
+  }
+  // Position of a body in the frame of the world positions
+  typename Policy::Pos position(const Body &b) const { return b.positionFrom(_origin); }
+
+  std::vector<tIndex> _targets;
+  GridCell _origin;
+};
+
+// F = M*g
+template<typename Policy>
+class UniformGravityT : public ForceGeneratorT<Policy> {
+public:
+  typedef typename Policy::Real Real;
+  typedef typename Policy::Vec Vec;
+  typedef BodyAttributesT<Policy> Body;
+
+  explicit UniformGravityT(const Vec &g = Vec(0, -9.8, 0)) : _g(g) {}
+
+  tIndex apply(
+    const std::vector<Body *> &bodies, const Real, const Real) override {
+    const tIndex n = this->targetCount(bodies);
+    for(tIndex i = 0; i < n; ++i) {
+      Body &b = this->target(bodies, i);
+      b.F += _g * b.M;
+    }
+    return 0;
+  }
+
+  Vec g() const { return _g; }
+  void setG(const Vec &g) { _g = g; }
+
+private:
+  Vec _g;
+};
+
+// F = -(k1 + k2*|V|)*V and tau = -kw*omega, i.e., linear and quadratic drag
+// on the translation, and linear drag on the rotation
+template<typename Policy>
+class DragT : public ForceGeneratorT<Policy> {
+public:
+  typedef typename Policy::Real Real;
+  typedef BodyAttributesT<Policy> Body;
+
+  explicit DragT(const Real k1 = 0, const Real k2 = 0, const Real kw = 0)
+    : _k1(k1), _k2(k2), _kw(kw) {}
+
+  tIndex apply(
+    const std::vector<Body *> &bodies, const Real, const Real) override {
+    const tIndex n = this->targetCount(bodies);
+    for(tIndex i = 0; i < n; ++i) {
+      Body &b = this->target(bodies, i);
+      b.F -= b.V * (_k1 + _k2*b.V.length());
+      b.tau -= b.omega * _kw;
+    }
+    return 0;
+  }
+
+private:
+  Real _k1, _k2, _kw;
+};
+
+// Damped springs between anchor points of two bodies, or between a body and
+// a fixed point in the world
+template<typename Policy>
+class SpringsT : public ForceGeneratorT<Policy> {
+public:
+  typedef typename Policy::Real Real;
+  typedef typename Policy::Vec Vec;
+  typedef typename Policy::Pos Pos;
+  typedef BodyAttributesT<Policy> Body;
+
+  static const tIndex WORLD = std::numeric_limits<tIndex>::max();
+
+  struct Spring {
+    tIndex a, b;     // Body indices; b can be WORLD
+    Vec ra, rb;      // Anchors in body space (world position if b is WORLD)
+    Real restLength;
+    Real k;          // Stiffness
+    Real c;          // Damping
+  };
+
+  void addSpring(
+    const tIndex a, const Vec &ra, const tIndex b, const Vec &rb,
+    const Real restLength, const Real k, const Real c = 0) {
+    Spring s;
+    s.a = a; s.b = b; s.ra = ra; s.rb = rb;
+    s.restLength = restLength; s.k = k; s.c = c;
+    _springs.push_back(s);
+  }
+  const std::vector<Spring>& springs() const { return _springs; }
+
+  void shiftOrigin(const Pos &delta) override {
+    for(Spring &s : _springs)
+      if(s.b == WORLD) s.rb = Vec(Pos(Pos(s.rb) - delta));
+  }
+
+  tIndex apply(
+    const std::vector<Body *> &bodies, const Real, const Real) override {
+    for(const Spring &s : _springs) {
+      Body &A = *bodies[s.a];
+      const Vec ra = A.toWorld(s.ra);
+      const Vec va = A.V + A.omega.crossProduct(ra);
+
+      Vec d, vb(0), rb(0);
+      Body *B = nullptr;
+      if(s.b != WORLD) {
+        B = bodies[s.b];
+        rb = B->toWorld(s.rb);
+        vb = B->V + B->omega.crossProduct(rb);
+        d = A.offsetTo(*B);
+      } else {
+        // Positions are only subtracted at full precision
+        d = Vec(Pos(Pos(s.rb) - this->position(A)));
+      }
+      d += rb - ra;
+      const Real len = d.length();
+      if(len == 0) continue;
+      d /= len;
+      const Vec f = d * (s.k*(len - s.restLength) + s.c*d.dotProduct(vb - va));
+
+      A.F += f;
+      A.tau += ra.crossProduct(f);
+      if(B) {
+        B->F -= f;
+        B->tau -= rb.crossProduct(f);
+      }
+    }
+    return 0;
+  }
+
+private:
+  std::vector<Spring> _springs;
+};
+
+// Inverse-square attraction towards a fixed point, F = s*M*(c - X)/r^3, with
+// a softening length to keep the force bounded near the center
+template<typename Policy>
+class PointAttractorT : public ForceGeneratorT<Policy> {
+public:
+  typedef typename Policy::Real Real;
+  typedef typename Policy::Vec Vec;
+  typedef typename Policy::Pos Pos;
+  typedef BodyAttributesT<Policy> Body;
+
+  explicit PointAttractorT(
+    const Pos &center = Pos(0), const Real strength = 1,
+    const Real softening = 1e-2)
+    : _c(center), _s(strength), _eps2(softening*softening) {}
+
+  tIndex apply(
+    const std::vector<Body *> &bodies, const Real, const Real) override {
+    const tIndex n = this->targetCount(bodies);
+    for(tIndex i = 0; i < n; ++i) {
+      Body &b = this->target(bodies, i);
+      const Vec d = Vec(Pos(_c - this->position(b)));
+      const Real r2 = d.lengthSquare() + _eps2;
+      b.F += d * (_s*b.M/(r2*std::sqrt(r2)));
+    }
+    return 0;
+  }
+
+  void setCenter(const Pos &c) { _c = c; }
+  void shiftOrigin(const Pos &delta) override { _c -= delta; }
+
+private:
+  Pos _c;
+  Real _s, _eps2;
+};
+
+// Instant impulses J applied at body-space points at given times. Each one
+// is applied as the constant force J/dt over the step containing its time,
+// so a rejected and retried step applies it again consistently.
+template<typename Policy>
+class ScheduledImpulsesT : public ForceGeneratorT<Policy> {
+public:
+  typedef typename Policy::Real Real;
+  typedef typename Policy::Vec Vec;
+  typedef BodyAttributesT<Policy> Body;
+
+  struct Impulse {
+    Real t;
+    tIndex body;
+    Vec J;          // Impulse in world space
+    Vec r;          // Point of application in body space
+  };
+
+  void addImpulse(
+    const Real t, const tIndex body, const Vec &J, const Vec &r = Vec(0)) {
+    Impulse imp;
+    imp.t = t; imp.body = body; imp.J = J; imp.r = r;
+    _impulses.insert(
+      std::upper_bound(_impulses.begin(), _impulses.end(), imp, earlier), imp);
+  }
+
+  tIndex apply(
+    const std::vector<Body *> &bodies, const Real t, const Real dt) override {
+    Impulse key;
+    key.t = t;
+    tIndex events = 0;
+    for(auto it = std::lower_bound(_impulses.begin(), _impulses.end(), key, earlier);
+        it != _impulses.end() && it->t < t + dt; ++it) {
+      Body &b = *bodies[it->body];
+      const Vec f = it->J / dt;
+      b.F += f;
+      b.tau += b.toWorld(it->r).crossProduct(f);
+      ++events;
+    }
+    return events;
+  }
+
+private:
+  static bool earlier(const Impulse &a, const Impulse &b) { return a.t < b.t; }
+
+  std::vector<Impulse> _impulses;  // Sorted by time
+};
+
+typedef ForceGeneratorT<FloatPrecision> ForceGenerator;
+typedef UniformGravityT<FloatPrecision> UniformGravity;
+typedef DragT<FloatPrecision> Drag;
+typedef SpringsT<FloatPrecision> Springs;
+typedef PointAttractorT<FloatPrecision> PointAttractor;
+typedef ScheduledImpulsesT<FloatPrecision> ScheduledImpulses;
+
+#endif  /* _FORCEGENERATORS_HPP_ */
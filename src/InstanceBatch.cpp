@@ -0,0 +1,35 @@
+#include "InstanceBatch.h"
+
+InstanceBatch::~InstanceBatch()
+{
+  clear();
+}
+
+// Each frame goes to the next region of the ring, so the instance
+// attributes are pointed at it again. Nothing is drawn this frame if the
+// region could not be written.
+void InstanceBatch::upload()
+{
+  _uploaded = static_cast<GLsizei>(_transforms.size());
+  if(!_uploaded) return;
+  const GLintptr offset = _stream.write(_transforms.data(), _transforms.size()*sizeof(glm::mat4));
+  if(offset < 0) {
+    _uploaded = 0;
+    return;
+  }
+  _mesh->setInstanceBuffer(_stream.id(), offset);
+}
+
+void InstanceBatch::render()
+{
+  if(!_uploaded) return;
+  _mesh->renderInstanced(_uploaded);
+  _stream.fence();
+}
+
+void InstanceBatch::clear()
+{
+  _transforms.clear();
+  _uploaded = 0;
+  _stream.clear();
+}
@@ -0,0 +1,53 @@
+#ifndef INSTANCE_BATCH_H
+#define INSTANCE_BATCH_H
+
+#include <glad/gl.h>
+#include <vector>
+#include <memory>
+
+#include <glm/glm.hpp>
+#include <glm/ext.hpp>
+
+#include "Mesh.h"
+#include "StreamBuffer.h"
+
+// All the bodies sharing one shape: one mesh on the GPU, one model matrix
+// per instance, drawn with one instanced draw call. The normal matrix is
+// derived from the model matrix in the vertex shader.
+class InstanceBatch {
+public:
+  explicit InstanceBatch(std::shared_ptr<Mesh> mesh) : _mesh(mesh) {}
+  virtual ~InstanceBatch();
+  InstanceBatch(const InstanceBatch &) = delete;
+  InstanceBatch& operator=(const InstanceBatch &) = delete;
+
+  std::shared_ptr<Mesh> mesh() const { return _mesh; }
+
+  const std::vector<glm::mat4> &transforms() const { return _transforms; }
+  std::vector<glm::mat4> &transforms() { return _transforms; }
+
+  // One pass over the bodies: the transform of instance i is the world
+  // matrix of bodies[i] times meshToBody, e.g., to place a mesh given in
+  // its own space
+  template<typename Body>
+  void gather(const std::vector<Body *> &bodies, const glm::mat4 &meshToBody = glm::mat4(1.0)) {
+    _transforms.resize(bodies.size());
+    for(size_t i = 0; i < bodies.size(); ++i)
+      _transforms[i] = bodies[i]->worldMat()*meshToBody;
+  }
+
+  // Stream the transforms to the GPU, once per frame before render(); the
+  // previous frames may still be drawing from the buffer
+  void upload();
+  void render();
+  void clear();
+
+private:
+  std::shared_ptr<Mesh> _mesh;
+  std::vector<glm::mat4> _transforms;
+
+  StreamBuffer _stream;
+  GLsizei _uploaded = 0;        // Instances in the region last written
+};
+
+#endif  // INSTANCE_BATCH_H
@@ -0,0 +1,239 @@
+// ----------------------------------------------------------------------------
+// MassProperties.hpp
+//
+//  Created on: 18 Oct 2026
+//      Author: Kiwon Um
+//        Mail: kiwon.um@telecom-paris.fr
+//
+// Description: Mass properties of closed triangle meshes (DO NOT DISTRIBUTE!)
+//
+// Copyright 2020-2024 Kiwon Um
+//
+// The copyright to the computer program(s) herein is the property of Kiwon Um,
+// Telecom Paris, France. The program(s) may be used and/or copied only with
+// the written permission of Kiwon Um or in accordance with the terms and
+// conditions stipulated in the agreement/contract under which the program(s)
+// have been supplied.
+// ----------------------------------------------------------------------------
+
+#ifndef _MASSPROPERTIES_HPP_
+#define _MASSPROPERTIES_HPP_
+
+#include <glm/gtc/quaternion.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "RigidBody.hpp"
+#include "Parallel.hpp"
+#include "Mesh.h"
+
+template<typename Policy>
+struct MassPropertiesT {
+  typedef typename Policy::Real Real;
+  typedef typename Policy::Vec Vec;
+  typedef typename Policy::Pos Pos;
+  typedef typename Policy::Mat Mat;
+
+  Real volume;
+  Real mass;
+  Pos com;                 // Center of mass in mesh space
+  Mat inertia;             // Inertia tensor about the center of mass
+  Vec principalMoments;    // Eigenvalues of the inertia tensor
+  Mat principalAxes;       // Rotation whose columns are the principal axes
+};
+
+typedef MassPropertiesT<FloatPrecision> MassProperties;
+
+// FNV-1a hash of the vertex positions and triangle indices
+inline std::uint64_t meshContentHash(const Mesh &mesh)
+{
+  std::uint64_t h = 14695981039346656037ULL;
+  auto feed = [&h](const void *data, const std::size_t size) {
+    const unsigned char *p = static_cast<const unsigned char *>(data);
+    for(std::size_t i = 0; i < size; ++i) {
+      h ^= p[i];
+      h *= 1099511628211ULL;
+    }
+  };
+  const std::vector<glm::vec3> &P = mesh.vertexPositions();
+  const std::vector<glm::uvec3> &T = mesh.triangleIndices();
+  const std::size_t nv = P.size(), nt = T.size();
+  feed(&nv, sizeof(nv));
+  feed(&nt, sizeof(nt));
+  if(nv) feed(P.data(), nv*sizeof(glm::vec3));
+  if(nt) feed(T.data(), nt*sizeof(glm::uvec3));
+  return h;
+}
+
+// Volume integrals over a closed, consistently wound mesh: each triangle
+// spans a signed tetrahedron with the origin, and the tetrahedra sum to the
+// solid. Triangles are integrated in parallel, in fixed-size blocks summed
+// in a fixed order so the result does not depend on the thread count.
+// The integrals are accumulated in double whatever the policy.
+template<typename Policy = FloatPrecision>
+MassPropertiesT<Policy> computeMassPropertiesUncached(
+  const Mesh &mesh, const typename Policy::Real density)
+{
+  typedef typename Policy::Real Real;
+  typedef typename Policy::PosReal PosReal;
+  typedef typename Policy::Pos Pos;
+  typedef typename Policy::Mat Mat;
+
+  struct Moments {
+    double v;          // Volume
+    double m[3];       // First moments
+    double c[3][3];    // Second moments, int x_i x_j dV
+  };
+
+  const std::vector<glm::vec3> &P = mesh.vertexPositions();
+  const std::vector<glm::uvec3> &T = mesh.triangleIndices();
+  const tIndex block = 4096;
+  const tIndex nt = static_cast<tIndex>(T.size());
+  const tIndex nb = (nt + block - 1)/block;
+  std::vector<Moments> partial(nb);
+
+  parallelFor(0, nb, [&](const tIndex k) {
+    Moments s = {0, {0, 0, 0}, {{0, 0, 0}, {0, 0, 0}, {0, 0, 0}}};
+    for(tIndex t = k*block; t < std::min(nt, (k + 1)*block); ++t) {
+      const glm::dvec3 a(P[T[t][0]]), b(P[T[t][1]]), c(P[T[t][2]]);
+      const double det = glm::dot(a, glm::cross(b, c));   // 6 x volume
+      const glm::dvec3 sum = a + b + c;
+      s.v += det/6;
+      for(tIndex i = 0; i < 3; ++i) {
+        s.m[i] += det*sum[i]/24;
+        // Covariance of a tetrahedron with a vertex at the origin
+        for(tIndex j = 0; j < 3; ++j)
+          s.c[i][j] += det*(a[i]*a[j] + b[i]*b[j] + c[i]*c[j] + sum[i]*sum[j])/120;
+      }
+    }
+    partial[k] = s;
+  }, 1);
+
+  Moments s = {0, {0, 0, 0}, {{0, 0, 0}, {0, 0, 0}, {0, 0, 0}}};
+  for(const Moments &p : partial) {
+    s.v += p.v;
+    for(tIndex i = 0; i < 3; ++i) {
+      s.m[i] += p.m[i];
+      for(tIndex j = 0; j < 3; ++j) s.c[i][j] += p.c[i][j];
+    }
+  }
+
+  MassPropertiesT<Policy> mp;
+  // Inward winding gives a negative volume, and all moments flip sign
+  const double sign = (s.v < 0) ? -1 : 1;
+  const double vol = sign*s.v;
+  mp.volume = static_cast<Real>(vol);
+  mp.mass = static_cast<Real>(density*vol);
+  const double com[3] = {
+    vol > 0 ? sign*s.m[0]/vol : 0, vol > 0 ? sign*s.m[1]/vol : 0, vol > 0 ? sign*s.m[2]/vol : 0 };
+  mp.com = Pos(static_cast<PosReal>(com[0]), static_cast<PosReal>(com[1]),
+               static_cast<PosReal>(com[2]));
+
+  // Second moments about the center of mass, then I = tr(C) Id - C
+  double C[3][3];
+  for(tIndex i = 0; i < 3; ++i)
+    for(tIndex j = 0; j < 3; ++j)
+      C[i][j] = density*(sign*s.c[i][j] - vol*com[i]*com[j]);
+  const double tr = C[0][0] + C[1][1] + C[2][2];
+  mp.inertia = Mat(tr - C[0][0], -C[0][1], -C[0][2],
+                   -C[1][0], tr - C[1][1], -C[1][2],
+                   -C[2][0], -C[2][1], tr - C[2][2]);
+
+  mp.inertia.symmetricEigen(mp.principalMoments, mp.principalAxes);
+  return mp;
+}
+
+// Same, cached by mesh content: loading the same mesh again skips the
+// integration. Properties are stored for unit density, one cache per policy.
+template<typename Policy = FloatPrecision>
+MassPropertiesT<Policy> computeMassProperties(
+  const Mesh &mesh, const typename Policy::Real density)
+{
+  static std::mutex mutex;
+  static std::unordered_map<std::uint64_t, MassPropertiesT<Policy> > cache;
+
+  const std::uint64_t key = meshContentHash(mesh);
+  MassPropertiesT<Policy> mp;
+  bool found = false;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = cache.find(key);
+    if(it != cache.end()) {
+      mp = it->second;
+      found = true;
+    }
+  }
+  if(!found) {
+    mp = computeMassPropertiesUncached<Policy>(mesh, 1);
+    std::lock_guard<std::mutex> lock(mutex);
+    cache[key] = mp;
+  }
+
+  mp.mass *= density;
+  mp.inertia *= density;
+  mp.principalMoments *= density;
+  return mp;
+}
+
+// Rigid body of uniform density bounded by a closed mesh. The body frame is
+// the principal frame at the center of mass, so the diagonal inertia path
+// applies; the body starts where the mesh is, i.e., X is the center of mass
+// and q the orientation of the principal axes in mesh space.
+template<typename Policy>
+class MeshBodyT : public BodyAttributesT<Policy> {
+public:
+  typedef typename Policy::Real Real;
+  typedef typename Policy::Vec Vec;
+  typedef typename Policy::Pos Pos;
+  typedef typename Policy::Mat Mat;
+
+  explicit MeshBodyT(
+    const Mesh &mesh,
+    Real dens = 10.0,
+    const Vec v0 = Vec(0, 0, 0),
+    const Vec omega0 = Vec(0, 0, 0))
+    : props(computeMassProperties<Policy>(mesh, dens))
+  {
+    this->V = v0;
+    this->omega = omega0;
+
+    this->M = props.mass;
+    this->setInertia(Mat(props.principalMoments));
+
+    const Mat &R = props.principalAxes;
+    glm::mat<3, 3, Real, glm::defaultp> r;
+    for(tIndex i = 0; i < 3; ++i)
+      for(tIndex j = 0; j < 3; ++j)
+        r[j][i] = R(i, j);
+    this->q = glm::normalize(glm::quat_cast(r));
+    this->X = props.com;
+
+    this->P = this->V * this->M;
+    this->L = this->toWorld(this->I0 * this->toBody(this->omega));
+
+    // Vertices in the principal frame
+    this->vdata0.reserve(mesh.vertexPositions().size());
+    for(const glm::vec3 &p : mesh.vertexPositions())
+      this->vdata0.push_back(R.transposedMul(Vec(Pos(Pos(p.x, p.y, p.z) - props.com))));
+
+    // Mesh space to body space, for the rendering
+    _meshToBody = glm::mat4(glm::mat3(glm::transpose(r)));
+    _meshToBody = glm::translate(_meshToBody, -glm::vec3(props.com[0], props.com[1], props.com[2]));
+  }
+
+  // Model matrix for rendering the original mesh
+  glm::mat4 meshMat() const { return this->worldMat()*_meshToBody; }
+
+  MassPropertiesT<Policy> props;
+
+private:
+  glm::mat4 _meshToBody;
+};
+
+typedef MeshBodyT<FloatPrecision> MeshBody;
+
+#endif  /* _MASSPROPERTIES_HPP_ */
@@ -19,13 +19,21 @@
 #ifndef _MATRIX3X3_HPP_
 #define _MATRIX3X3_HPP_
 
+#include <algorithm>
 #include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <limits>
 
 #include "typedefs.hpp"
 #include "Vector3.hpp"
 
 template<typename T> class Vector3;
 
+template<typename T>
+void symmetricEigenKernel(
+  T a00, T a01, T a02, T a11, T a12, T a22, T &l0, T &l1, T &l2, T V[9]);
+
 template<typename T>
 class Matrix3x3 {
 public:
@@ -142,6 +150,19 @@ public:
       v20*m.v20 + v21*m.v21 + v22*m.v22);
   }
 
+  Matrix3x3 mulDiagonal(const Vector3<T> &d) const {
+    // M*diag(d)
+    return Matrix3x3(
+      v00*d.x, v01*d.y, v02*d.z,
+      v10*d.x, v11*d.y, v12*d.z,
+      v20*d.x, v21*d.y, v22*d.z);
+  }
+
+  bool isDiagonal() const {
+    return (v01==0 && v02==0 && v10==0 && v12==0 && v20==0 && v21==0);
+  }
+  Vector3<T> diagonal() const { return Vector3<T>(v00, v11, v22); }
+
   bool operator==(const Matrix3x3 &m) const {
     return
       (v00==m.v00 && v01==m.v01 && v02==m.v02 &&
@@ -161,7 +182,7 @@ public:
             v20*v20 + v21*v21 + v22*v22);
   }
 
-  tReal determinant() const {
+  T determinant() const {
     return
       (v00*v11*v22 - v00*v12*v21 + v01*v12*v20
        - v01*v10*v22 + v02*v10*v21 - v02*v11*v20);
@@ -172,18 +193,18 @@ public:
   }
   Matrix3x3& invert() { return *this = inverse(); }
   Matrix3x3 inverse() const {
-    const tReal det=determinant(); assert(det);
-    const tReal idet=1e0/det;
+    const T det=determinant(); assert(det);
+    const T idet=1e0/det;
     return Matrix3x3(
       idet*(v11*v22-v12*v21), idet*(v02*v21-v01*v22), idet*(v01*v12-v02*v11),
       idet*(v12*v20-v10*v22), idet*(v00*v22-v02*v20), idet*(v02*v10-v00*v12),
       idet*(v10*v21-v11*v20), idet*(v01*v20-v00*v21), idet*(v00*v11-v01*v10));
   }
   bool getInverse(Matrix3x3 &inv) const {
-    const tReal det=determinant();
+    const T det=determinant();
     // if(isEqualEpsilon(det, 0)) return false;
 
-    const tReal idet=1e0/det;
+    const T idet=1e0/det;
     inv.v00=idet*(v11*v22-v12*v21);
     inv.v01=idet*(v02*v21-v01*v22);
     inv.v02=idet*(v01*v12-v02*v11);
@@ -199,56 +220,97 @@ public:
     return true;
   }
 
-  tReal normOne() const {
+  // Cheaper inverses when the kind of the matrix is known. A rotation is
+  // inverted by transposedMul() without forming its transpose.
+  Matrix3x3 symmetricInverse() const {
+    // The adjugate is symmetric too: 6 cofactors instead of 9
+    const T c00 = v11*v22 - v12*v12, c01 = v02*v12 - v01*v22, c02 = v01*v12 - v02*v11;
+    const T c11 = v00*v22 - v02*v02, c12 = v01*v02 - v00*v12, c22 = v00*v11 - v01*v01;
+    const T det = v00*c00 + v01*c01 + v02*c02; assert(det);
+    const T idet = 1/det;
+    return Matrix3x3(
+      idet*c00, idet*c01, idet*c02,
+      idet*c01, idet*c11, idet*c12,
+      idet*c02, idet*c12, idet*c22);
+  }
+  Matrix3x3 diagonalInverse() const {
+    return Matrix3x3(Vector3<T>(1/v00, 1/v11, 1/v22));
+  }
+
+  // Solution x of M*x = b by Cramer's rule, without forming the inverse
+  Vector3<T> solve(const Vector3<T> &b) const {
+    const Vector3<T> c0(v00, v10, v20), c1(v01, v11, v21), c2(v02, v12, v22);
+    const Vector3<T> c12 = c1.crossProduct(c2);
+    const T det = c0.dotProduct(c12); assert(det);
+    const T idet = 1/det;
+    return Vector3<T>(
+      b.dotProduct(c12)*idet,
+      b.dotProduct(c2.crossProduct(c0))*idet,
+      b.dotProduct(c0.crossProduct(c1))*idet);
+  }
+
+  T normOne() const {
     // the maximum absolute column sum of the matrix
-    return max(std::fabs(v00)+std::fabs(v10)+std::fabs(v20),
-               std::fabs(v01)+std::fabs(v11)+std::fabs(v21),
-               std::fabs(v02)+std::fabs(v12)+std::fabs(v22));
+    return std::max(std::max(std::fabs(v00)+std::fabs(v10)+std::fabs(v20),
+                             std::fabs(v01)+std::fabs(v11)+std::fabs(v21)),
+                    std::fabs(v02)+std::fabs(v12)+std::fabs(v22));
   }
-  tReal normInf() const {
+  T normInf() const {
     // the maximum absolute row sum of the matrix
-    return max(std::fabs(v00)+std::fabs(v01)+std::fabs(v02),
-               std::fabs(v10)+std::fabs(v11)+std::fabs(v12),
-               std::fabs(v20)+std::fabs(v21)+std::fabs(v22));
+    return std::max(std::max(std::fabs(v00)+std::fabs(v01)+std::fabs(v02),
+                             std::fabs(v10)+std::fabs(v11)+std::fabs(v12)),
+                    std::fabs(v20)+std::fabs(v21)+std::fabs(v22));
   }
 
   Vector3<T> eigenvalues() const {
     Vector3<T> eigen;
 
-    const tReal b = - v00 - v11 - v22;
-    const tReal c = v00*(v11+v22) + v11*v22 - v12*v21 - v01*v10 - v02*v20;
-    tReal d =
+    const T b = - v00 - v11 - v22;
+    const T c = v00*(v11+v22) + v11*v22 - v12*v21 - v01*v10 - v02*v20;
+    T d =
       - v00*(v11*v22-v12*v21) - v20*(v01*v12-v11*v02) - v10*(v02*v21-v22*v01);
-    const tReal f = (3.0*c - b*b)/3.0;
-    const tReal g = (2.0*b*b*b - 9.0*b*c + 27.0*d)/27.0;
-    const tReal h = g*g/4.0 + f*f*f/27.0;
+    const T f = (3.0*c - b*b)/3.0;
+    const T g = (2.0*b*b*b - 9.0*b*c + 27.0*d)/27.0;
+    const T h = g*g/4.0 + f*f*f/27.0;
 
-    tReal sign;
+    T sign;
     if(h>0) {
-      tReal r = -g/2.0 + std::sqrt(h);
+      T r = -g/2.0 + std::sqrt(h);
       if(r<0) { r = -r; sign = -1.0; } else sign = 1.0;
-      tReal s = sign*std::pow(r, 1.0/3.0);
-      tReal t = -g/2.0-std::sqrt(h);
+      T s = sign*std::pow(r, 1.0/3.0);
+      T t = -g/2.0-std::sqrt(h);
       if(t<0) { t = -t; sign = -1.0; } else sign = 1.0;
-      tReal u = sign*std::pow(t, 1.0/3.0);
+      T u = sign*std::pow(t, 1.0/3.0);
       eigen[0] = (s + u) - b/3.0; eigen[1] = eigen[2] = 0;
     } else if(h==0) {
       if(d<0) { d = -d; sign = -1.0; } sign = 1.0;
       eigen[0] = -1.0*sign*std::pow(d, 1.0/3.0); eigen[1] = eigen[2] = 0;
     } else {
-      const tReal i = std::sqrt(g*g/4.0 - h);
-      const tReal j = std::pow(i, 1.0/3.0);
-      const tReal k = std::acos(-g/(2.0*i));
-      const tReal l = -j;
-      const tReal m = std::cos(k/3.0);
-      const tReal n = std::sqrt(3.0)*std::sin(k/3.0);
-      const tReal p = -b/3.0;
+      const T i = std::sqrt(g*g/4.0 - h);
+      const T j = std::pow(i, 1.0/3.0);
+      const T k = std::acos(-g/(2.0*i));
+      const T l = -j;
+      const T m = std::cos(k/3.0);
+      const T n = std::sqrt(3.0)*std::sin(k/3.0);
+      const T p = -b/3.0;
       eigen[0] = 2e0*j*m + p;
       eigen[1] = l*(m+n) + p;
       eigen[2] = l*(m-n) + p;
     }
 
-    return eigen.sortDesc();
+    // Descending order
+    if(eigen[0] < eigen[1]) std::swap(eigen[0], eigen[1]);
+    if(eigen[1] < eigen[2]) std::swap(eigen[1], eigen[2]);
+    if(eigen[0] < eigen[1]) std::swap(eigen[0], eigen[1]);
+    return eigen;
+  }
+
+  // Eigen-decomposition of a symmetric matrix: eigenvalues in descending
+  // order and the corresponding unit eigenvectors as the columns of a
+  // rotation matrix. Only the upper triangle is read.
+  void symmetricEigen(Vector3<T> &values, Matrix3x3 &vectors) const {
+    symmetricEigenKernel(
+      v00, v01, v02, v11, v12, v22, values.x, values.y, values.z, vectors.v1);
   }
 
   static Matrix3x3 I() { return Matrix3x3(1,0,0, 0,1,0, 0,0,1); }
@@ -276,4 +338,119 @@ crossProductMatrix(const Vector3<T> &v) {
   return Matrix3x3<T>(0, -v.z, v.y,  v.z, 0, -v.x,  -v.y, v.x, 0);
 }
 
+// Jacobi eigen-decomposition of W symmetric matrices at once, one per lane.
+// A holds the upper triangles (00, 01, 02, 11, 12, 22) and receives the
+// eigenvalues on its diagonal entries in descending order; V receives the
+// row-major eigenvectors (columns) as rotations. The sweep count is fixed
+// and there are no data-dependent branches, so every step is a plain loop
+// over the lanes that vectorizes for W > 1.
+template<typename T, int W>
+struct SymmetricEigenLanes {
+  // Index of (i, j), i <= j, in the upper triangle
+  static int sym(const int i, const int j) { return i ? i + j + 1 : j; }
+
+  // Rotation in the (p, q) plane zeroing A(p, q), by the smallest angle;
+  // the tangent is computed without dividing by the pivot, which may be 0.
+  // Off-diagonal entries below tol are flushed to zero: they would only
+  // keep shrinking quadratically into subnormals, which are very slow.
+  static void rotate(
+    T (&A)[6][W], T (&V)[9][W], const T (&tol)[W], const int p, const int q) {
+    const int r = 3 - p - q;
+    T *app = A[sym(p, p)], *aqq = A[sym(q, q)], *apq = A[sym(p, q)];
+    T *arp = A[p < r ? sym(p, r) : sym(r, p)], *arq = A[q < r ? sym(q, r) : sym(r, q)];
+    const T tiny = std::numeric_limits<T>::min();
+    for(int l = 0; l < W; ++l) {
+      const T d = aqq[l] - app[l], e = 2*apq[l];
+      const T t = (d >= 0 ? e : -e)/
+        std::max(std::fabs(d) + std::sqrt(d*d + e*e), tiny);
+      const T c = 1/std::sqrt(1 + t*t), s = t*c;
+      app[l] -= t*apq[l];
+      aqq[l] += t*apq[l];
+      apq[l] = 0;
+      const T rp = arp[l], rq = arq[l];
+      const T xp = c*rp - s*rq, xq = s*rp + c*rq;
+      arp[l] = std::fabs(xp) < tol[l] ? 0 : xp;
+      arq[l] = std::fabs(xq) < tol[l] ? 0 : xq;
+      for(int k = 0; k < 3; ++k) {
+        const T x = V[3*k + p][l], y = V[3*k + q][l];
+        V[3*k + p][l] = c*x - s*y;
+        V[3*k + q][l] = s*x + c*y;
+      }
+    }
+  }
+
+  // Compare and swap eigenpairs i < j; negating one of the swapped columns
+  // keeps V a rotation
+  static void order(T (&A)[6][W], T (&V)[9][W], const int i, const int j) {
+    T *li = A[sym(i, i)], *lj = A[sym(j, j)];
+    for(int l = 0; l < W; ++l) {
+      const bool sw = li[l] < lj[l];
+      const T x = li[l];
+      li[l] = sw ? lj[l] : li[l];
+      lj[l] = sw ? x : lj[l];
+      for(int k = 0; k < 3; ++k) {
+        const T y = V[3*k + i][l];
+        V[3*k + i][l] = sw ? V[3*k + j][l] : y;
+        V[3*k + j][l] = sw ? -y : V[3*k + j][l];
+      }
+    }
+  }
+
+  static void solve(T (&A)[6][W], T (&V)[9][W]) {
+    for(int k = 0; k < 9; ++k)
+      for(int l = 0; l < W; ++l) V[k][l] = (k%4 == 0) ? 1 : 0;
+    T tol[W];
+    for(int l = 0; l < W; ++l) {
+      T norm = 0;
+      for(int k = 0; k < 6; ++k) norm += std::fabs(A[k][l]);
+      tol[l] = norm*std::numeric_limits<T>::epsilon()*std::numeric_limits<T>::epsilon();
+    }
+    // Convergence is quadratic: 5 sweeps reach double precision
+    for(int sweep = 0; sweep < 5; ++sweep) {
+      rotate(A, V, tol, 0, 1);
+      rotate(A, V, tol, 0, 2);
+      rotate(A, V, tol, 1, 2);
+    }
+    order(A, V, 0, 1);
+    order(A, V, 0, 2);
+    order(A, V, 1, 2);
+  }
+};
+
+template<typename T>
+inline void symmetricEigenKernel(
+  T a00, T a01, T a02, T a11, T a12, T a22, T &l0, T &l1, T &l2, T V[9])
+{
+  T A[6][1] = {{a00}, {a01}, {a02}, {a11}, {a12}, {a22}}, U[9][1];
+  SymmetricEigenLanes<T, 1>::solve(A, U);
+  l0 = A[0][0]; l1 = A[3][0]; l2 = A[5][0];
+  for(int k = 0; k < 9; ++k) V[k] = U[k][0];
+}
+
+// Batched eigen-decomposition of n symmetric matrices stored as structure
+// of arrays: a[k][i] is the k-th upper-triangle entry (00, 01, 02, 11, 12,
+// 22) of matrix i, values[k][i] its k-th eigenvalue and vectors[k][i] the
+// k-th entry of its row-major eigenvector matrix.
+template<typename T>
+inline void symmetricEigenBatch(
+  const std::size_t n, const T *const a[6], T *const values[3], T *const vectors[9])
+{
+  const int W = 8;
+  T A[6][W], V[9][W];
+  for(std::size_t i0 = 0; i0 < n; i0 += W) {
+    const int m = static_cast<int>(std::min<std::size_t>(W, n - i0));
+    // Pad the last block with identity matrices
+    for(int k = 0; k < 6; ++k)
+      for(int l = 0; l < W; ++l)
+        A[k][l] = (l < m) ? a[k][i0 + l] : (k == 0 || k == 3 || k == 5);
+    SymmetricEigenLanes<T, W>::solve(A, V);
+    for(int l = 0; l < m; ++l) {
+      values[0][i0 + l] = A[0][l];
+      values[1][i0 + l] = A[3][l];
+      values[2][i0 + l] = A[5][l];
+      for(int k = 0; k < 9; ++k) vectors[k][i0 + l] = V[k][l];
+    }
+  }
+}
+
 #endif  /* _MATRIX3X3_HPP_ */
@@ -1,8 +1,15 @@
 #define _USE_MATH_DEFINES
 
 #include "Mesh.h"
+#include "MeshIO.hpp"
+#include "Parallel.hpp"
+
+#include <glm/gtc/packing.hpp>
 
 #include <cmath>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
 #include <algorithm>
 #include <iostream>
 #include <fstream>
@@ -27,24 +34,94 @@ void Mesh::computeBoundingSphere(glm::vec3 &center, float &radius) const
     radius = std::max(radius, distance(center, p));
 }
 
-void Mesh::recomputePerVertexNormals(bool angleBased)
+void Mesh::invalidateAdjacency()
 {
-  _vertexNormals.clear();
-  // Change the following code to compute a proper per-vertex normal
-  _vertexNormals.resize(_vertexPositions.size(), glm::vec3(0.0, 0.0, 0.0));
-
-  for(unsigned int tIt=0 ; tIt < _triangleIndices.size() ; ++tIt) {
-    glm::uvec3 t = _triangleIndices[tIt];
-    glm::vec3 n_t = glm::cross(
-      _vertexPositions[t[1]] - _vertexPositions[t[0]],
-      _vertexPositions[t[2]] - _vertexPositions[t[0]]);
-    _vertexNormals[t[0]] += n_t;
-    _vertexNormals[t[1]] += n_t;
-    _vertexNormals[t[2]] += n_t;
-  }
-  for(unsigned int nIt = 0 ; nIt < _vertexNormals.size() ; ++nIt) {
-    glm::normalize(_vertexNormals[nIt]);
+  _cornerOffsets.clear();
+  _vertexCorners.clear();
+}
+
+// Counting sort of the corners by vertex
+void Mesh::buildAdjacency()
+{
+  const size_t nv = _vertexPositions.size(), nc = 3*_triangleIndices.size();
+  _cornerOffsets.assign(nv + 1, 0);
+  for(const glm::uvec3 &t : _triangleIndices) {
+    ++_cornerOffsets[t[0] + 1];
+    ++_cornerOffsets[t[1] + 1];
+    ++_cornerOffsets[t[2] + 1];
   }
+  for(size_t v = 0; v < nv; ++v)
+    _cornerOffsets[v + 1] += _cornerOffsets[v];
+
+  _vertexCorners.resize(nc);
+  std::vector<unsigned int> cursor(_cornerOffsets.begin(), _cornerOffsets.end() - 1);
+  for(unsigned int c = 0; c < nc; ++c)
+    _vertexCorners[cursor[_triangleIndices[c/3][c%3]]++] = c;
+}
+
+// Three parallel passes: weighted face normal at each corner, gather of the
+// corners around each vertex, and normalization. Each vertex only reads
+// the corners of its own adjacency, so no synchronization is needed.
+void Mesh::recomputePerVertexNormals(bool angleBased)
+{
+  const tIndex nv = static_cast<tIndex>(_vertexPositions.size());
+  const tIndex nt = static_cast<tIndex>(_triangleIndices.size());
+  if(_cornerOffsets.size() != static_cast<size_t>(nv) + 1 ||
+     _vertexCorners.size() != 3*static_cast<size_t>(nt))
+    buildAdjacency();
+
+  // 1) Face normals: the cross product has the length of twice the triangle
+  // area, which gives the area weighting. For angle weighting, each corner
+  // also gets the factor turning it into the corner angle times the unit
+  // normal.
+  std::vector<glm::vec3> face(nt);
+  std::vector<float> weight(angleBased ? 3*static_cast<size_t>(nt) : 0);
+  parallelFor(0, nt, [&](const tIndex t) {
+    const glm::uvec3 &tri = _triangleIndices[t];
+    const glm::vec3 p[3] = {
+      _vertexPositions[tri[0]], _vertexPositions[tri[1]], _vertexPositions[tri[2]] };
+    const glm::vec3 n = glm::cross(p[1] - p[0], p[2] - p[0]);
+    face[t] = n;
+    if(!angleBased) return;
+    const float len = glm::length(n);
+    for(int k = 0; k < 3; ++k) {
+      const glm::vec3 a = p[(k+1)%3] - p[k], b = p[(k+2)%3] - p[k];
+      const float angle = std::atan2(glm::length(glm::cross(a, b)), glm::dot(a, b));
+      weight[3*t+k] = len > 0 ? angle/len : 0;
+    }
+  }, 4096);
+
+  // 2) Gather, into separate coordinate arrays for the last pass
+  std::vector<float> nx(nv), ny(nv), nz(nv);
+  parallelFor(0, nv, [&](const tIndex v) {
+    glm::vec3 n(0.f);
+    if(angleBased) {
+      for(unsigned int i = _cornerOffsets[v]; i < _cornerOffsets[v+1]; ++i)
+        n += face[_vertexCorners[i]/3]*weight[_vertexCorners[i]];
+    } else {
+      for(unsigned int i = _cornerOffsets[v]; i < _cornerOffsets[v+1]; ++i)
+        n += face[_vertexCorners[i]/3];
+    }
+    nx[v] = n.x;
+    ny[v] = n.y;
+    nz[v] = n.z;
+  }, 4096);
+
+  // 3) Normalize; the loop over contiguous coordinates compiles to SIMD
+  // code. Isolated vertices get the default normal.
+  _vertexNormals.resize(nv);
+  parallelForRange(0, nv, [&](const tIndex b, const tIndex e) {
+    float *x = nx.data(), *y = ny.data(), *z = nz.data();
+    for(tIndex v = b; v < e; ++v) {
+      const float l2 = x[v]*x[v] + y[v]*y[v] + z[v]*z[v];
+      const float s = l2 > 0 ? 1/std::sqrt(l2) : 0;
+      x[v] *= s;
+      y[v] *= s;
+      z[v] = l2 > 0 ? z[v]*s : 1;
+    }
+    for(tIndex v = b; v < e; ++v)
+      _vertexNormals[v] = glm::vec3(x[v], y[v], z[v]);
+  }, 4096);
 }
 
 void Mesh::recomputePerVertexTextureCoordinates()
@@ -239,46 +316,120 @@ void Mesh::addBox(const float w, const float h, const float d)
 //   glBindVertexArray(0); // Desactive the VAO just created. Will be activated at rendering time.
 // }
 
-void Mesh::init()
+void Mesh::init(bool quantized)
+{
+  upload(_vertexPositions.data(), _vertexNormals.data(), _vertexTexCoords.data(),
+         _vertexPositions.size(), _triangleIndices.data(), _triangleIndices.size(),
+         quantized);
+}
+
+void Mesh::initFromCache(const std::string &cacheFile, bool quantized)
 {
-  // Generate a GPU buffer to store the positions of the vertices
-  size_t vertexBufferSize = sizeof(glm::vec3)*_vertexPositions.size();
-  glGenBuffers(1, &_posVbo);
-  glBindBuffer(GL_ARRAY_BUFFER, _posVbo);
-  glBufferData(GL_ARRAY_BUFFER, vertexBufferSize, _vertexPositions.data(), GL_DYNAMIC_READ);
-
-  // Same for normal
-  glGenBuffers(1, &_normalVbo);
-  glBindBuffer(GL_ARRAY_BUFFER, _normalVbo);
-  glBufferData(GL_ARRAY_BUFFER, vertexBufferSize, _vertexNormals.data(), GL_DYNAMIC_READ);
-
-  // Same for texture coordinates
-  size_t texCoordBufferSize = sizeof(glm::vec2)*_vertexTexCoords.size();
-  glGenBuffers(1, &_texCoordVbo);
-  glBindBuffer(GL_ARRAY_BUFFER, _texCoordVbo);
-  glBufferData(GL_ARRAY_BUFFER, texCoordBufferSize, _vertexTexCoords.data(), GL_DYNAMIC_READ);
+  const MappedFile file(cacheFile);
+  MeshCacheHeader h;
+  if(file.size() < sizeof(h))
+    throw std::ios_base::failure("[Mesh Loader][initFromCache] Invalid cache " + cacheFile);
+  std::memcpy(&h, file.data(), sizeof(h));
+  if(!h.valid(file.size()) || h.normalCount != h.vertexCount || h.texCoordCount != h.vertexCount ||
+     !h.indicesValid(file.data()))
+    throw std::ios_base::failure("[Mesh Loader][initFromCache] Invalid cache " + cacheFile);
+
+  // The blocks are aligned within the page-aligned mapping
+  const char *base = file.data();
+  upload(reinterpret_cast<const glm::vec3 *>(base + h.positionOffset),
+         reinterpret_cast<const glm::vec3 *>(base + h.normalOffset),
+         reinterpret_cast<const glm::vec2 *>(base + h.texCoordOffset),
+         h.vertexCount,
+         reinterpret_cast<const glm::uvec3 *>(base + h.indexOffset),
+         h.triangleCount, quantized);
+}
+
+// Octahedral mapping of a unit vector to [-1,1]^2: project onto the
+// octahedron |x|+|y|+|z| = 1 and fold the lower half over the upper one.
+// Decoded by octDecode() in the vertex shaders.
+static glm::vec2 octEncode(const glm::vec3 &n)
+{
+  const float l1 = std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+  if(!(l1 > 0)) return glm::vec2(0.f);   // Decodes to +z
+  const glm::vec2 p = glm::vec2(n.x, n.y)/l1;
+  if(n.z >= 0) return p;
+  return glm::vec2((1 - std::abs(p.y))*(p.x >= 0 ? 1.f : -1.f),
+                   (1 - std::abs(p.x))*(p.y >= 0 ? 1.f : -1.f));
+}
+
+static GLshort snorm16(const float x)
+{
+  return static_cast<GLshort>(std::round(glm::clamp(x, -1.f, 1.f)*32767.f));
+}
+
+// One interleaved buffer for all attributes. Normals are always octahedral,
+// as two floats, or as two 16-bit normalized integers when quantized, where
+// texture coordinates are also half floats: 20 bytes per vertex instead of
+// 28 (and 32 for separate float buffers). Indices are 16-bit whenever the
+// vertex count allows it. The geometry never changes after the upload.
+void Mesh::upload(
+  const glm::vec3 *positions, const glm::vec3 *normals, const glm::vec2 *texCoords,
+  size_t vertexCount, const glm::uvec3 *triangles, size_t triangleCount, bool quantized)
+{
+  const size_t stride = quantized ? 20 : 28;
+  const size_t normalOffset = 12, texCoordOffset = quantized ? 16 : 20;
+  std::vector<unsigned char> vertices(stride*vertexCount);
+  parallelFor(0, static_cast<tIndex>(vertexCount), [&](const tIndex i) {
+    unsigned char *v = &vertices[stride*i];
+    std::memcpy(v, &positions[i], sizeof(glm::vec3));
+    const glm::vec2 e = octEncode(normals[i]);
+    if(quantized) {
+      const GLshort n[2] = { snorm16(e.x), snorm16(e.y) };
+      const GLushort t[2] = {
+        static_cast<GLushort>(glm::packHalf1x16(texCoords[i].x)),
+        static_cast<GLushort>(glm::packHalf1x16(texCoords[i].y)) };
+      std::memcpy(v + normalOffset, n, sizeof(n));
+      std::memcpy(v + texCoordOffset, t, sizeof(t));
+    } else {
+      std::memcpy(v + normalOffset, &e, sizeof(e));
+      std::memcpy(v + texCoordOffset, &texCoords[i], sizeof(glm::vec2));
+    }
+  }, 4096);
+
+  // Generate a GPU buffer to store the vertices
+  glGenBuffers(1, &_vbo);
+  glBindBuffer(GL_ARRAY_BUFFER, _vbo);
+  glBufferData(GL_ARRAY_BUFFER, vertices.size(), vertices.data(), GL_STATIC_DRAW);
 
   // Same for the index buffer that stores the list of indices of the triangles forming the mesh
-  size_t indexBufferSize = sizeof(glm::uvec3)*_triangleIndices.size();
   glGenBuffers(1, &_ibo);
   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _ibo);
-  glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexBufferSize, _triangleIndices.data(), GL_DYNAMIC_READ);
+  if(vertexCount <= 65536) {
+    std::vector<GLushort> indices(3*triangleCount);
+    for(size_t t = 0; t < triangleCount; ++t)
+      for(int k = 0; k < 3; ++k)
+        indices[3*t+k] = static_cast<GLushort>(triangles[t][k]);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size()*sizeof(GLushort), indices.data(), GL_STATIC_DRAW);
+    _indexType = GL_UNSIGNED_SHORT;
+  } else {
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(glm::uvec3)*triangleCount, triangles, GL_STATIC_DRAW);
+    _indexType = GL_UNSIGNED_INT;
+  }
+  _indexCount = static_cast<GLsizei>(3*triangleCount);
 
   // Create a single handle that joins together attributes (vertex positions, normals) and connectivity (triangles indices)
   glGenVertexArrays(1, &_vao);
   glBindVertexArray(_vao);
+  glBindBuffer(GL_ARRAY_BUFFER, _vbo);
+  const GLsizei s = static_cast<GLsizei>(stride);
 
   glEnableVertexAttribArray(0);
-  glBindBuffer(GL_ARRAY_BUFFER, _posVbo);
-  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3*sizeof(GLfloat), 0);
+  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, s, 0);
 
   glEnableVertexAttribArray(1);
-  glBindBuffer(GL_ARRAY_BUFFER, _normalVbo);
-  glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 3*sizeof(GLfloat), 0);
+  if(quantized)
+    glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, s, reinterpret_cast<void *>(normalOffset));
+  else
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, s, reinterpret_cast<void *>(normalOffset));
 
   glEnableVertexAttribArray(2);
-  glBindBuffer(GL_ARRAY_BUFFER, _texCoordVbo);
-  glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 2*sizeof(GLfloat), 0);
+  glVertexAttribPointer(2, 2, quantized ? GL_HALF_FLOAT : GL_FLOAT, GL_FALSE, s,
+                        reinterpret_cast<void *>(texCoordOffset));
 
   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _ibo);
 
@@ -288,31 +439,44 @@ void Mesh::init()
 void Mesh::render()
 {
   glBindVertexArray(_vao);      // Activate the VAO storing geometry data
-  glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(_triangleIndices.size()*3), GL_UNSIGNED_INT, 0);
+  glDrawElements(GL_TRIANGLES, _indexCount, _indexType, 0);
   // Call for rendering: stream the current GPU geometry through the current GPU program
 }
 
+void Mesh::setInstanceBuffer(GLuint buffer, GLintptr offset)
+{
+  glBindVertexArray(_vao);
+  glBindBuffer(GL_ARRAY_BUFFER, buffer);
+  for(GLuint c = 0; c < 4; ++c) {
+    glEnableVertexAttribArray(3 + c);
+    glVertexAttribPointer(3 + c, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4),
+                          reinterpret_cast<void *>(offset + c*sizeof(glm::vec4)));
+    glVertexAttribDivisor(3 + c, 1);
+  }
+  glBindVertexArray(0);
+}
+
+void Mesh::renderInstanced(GLsizei instanceCount)
+{
+  glBindVertexArray(_vao);
+  glDrawElementsInstanced(GL_TRIANGLES, _indexCount, _indexType, 0, instanceCount);
+}
+
 void Mesh::clear()
 {
   _vertexPositions.clear();
   _vertexNormals.clear();
   _vertexTexCoords.clear();
   _triangleIndices.clear();
+  _indexCount = 0;
+  invalidateAdjacency();
   if(_vao) {
     glDeleteVertexArrays(1, &_vao);
     _vao = 0;
   }
-  if(_posVbo) {
-    glDeleteBuffers(1, &_posVbo);
-    _posVbo = 0;
-  }
-  if(_normalVbo) {
-    glDeleteBuffers(1, &_normalVbo);
-    _normalVbo = 0;
-  }
-  if(_texCoordVbo) {
-    glDeleteBuffers(1, &_texCoordVbo);
-    _texCoordVbo = 0;
+  if(_vbo) {
+    glDeleteBuffers(1, &_vbo);
+    _vbo = 0;
   }
   if(_ibo) {
     glDeleteBuffers(1, &_ibo);
@@ -321,40 +485,255 @@ void Mesh::clear()
 }
 
 // Loads an OFF mesh file. See https://en.wikipedia.org/wiki/OFF_(file_format)
+// The file is memory-mapped and parsed in parallel chunks of whole lines,
+// one record (vertex or face) per line. A first pass counts the records of
+// each chunk, so every chunk knows the index of its first record; a second
+// one parses vertices in place and counts the triangles of the faces, and a
+// last one writes the triangles, fanning polygons, at their final offsets.
 void loadOFF(const std::string &filename, std::shared_ptr<Mesh> meshPtr)
 {
   std::cout << " > Start loading mesh <" << filename << ">" << std::endl;
   meshPtr->clear();
-  std::ifstream in(filename.c_str());
-  if(!in)
-    throw std::ios_base::failure("[Mesh Loader][loadOFF] Cannot open " + filename);
-  std::string offString;
-  unsigned int sizeV, sizeT, tmp;
-  in >> offString >> sizeV >> sizeT >> tmp;
+  const MappedFile file(filename);
+  const char *p = file.data(), *last = file.end();
+  const std::string error = "[Mesh Loader][loadOFF] Invalid file " + filename;
+
+  // Header: OFF keyword (possibly with a prefix such as C or N), then counts
+  auto skip = [&]() {
+    for(;;) {
+      while(p < last && std::isspace(static_cast<unsigned char>(*p))) ++p;
+      if(p < last && *p == '#') p = nextLine(p, last);
+      else break;
+    }
+  };
+  skip();
+  const char *key = p;
+  while(p < last && !std::isspace(static_cast<unsigned char>(*p))) ++p;
+  if(p - key < 3 || std::string(p - 3, p) != "OFF")
+    throw std::ios_base::failure(error);
+  unsigned int sizeV, sizeF, sizeE;
+  skip(); p = parseUInt(p, last, sizeV);
+  skip(); p = parseUInt(p, last, sizeF);
+  skip(); const char *q = parseUInt(p, last, sizeE);
+  if(q == p) throw std::ios_base::failure(error);
+  p = nextLine(q, last);
+
   auto &P = meshPtr->vertexPositions();
   auto &T = meshPtr->triangleIndices();
   P.resize(sizeV);
-  T.resize(sizeT);
-  size_t tracker = (sizeV + sizeT)/20;
-  std::cout << " > [" << std::flush;
-  for(unsigned int i=0; i<sizeV; ++i) {
-    if(i % tracker == 0)
-      std::cout << "-" << std::flush;
-    in >> P[i][0] >> P[i][1] >> P[i][2];
-  }
-  int s;
-  for(unsigned int i=0; i<sizeT; ++i) {
-    if((sizeV + i) % tracker == 0)
-      std::cout << "-" << std::flush;
-    in >> s;
-    for(unsigned int j=0; j<3; ++j)
-      in >> T[i][j];
+
+  const std::size_t body = last - p;
+  const tIndex nc = static_cast<tIndex>(std::max<std::size_t>(
+    1, std::min<std::size_t>(4*threadCount(), body >> 16)));
+  const std::vector<const char *> cuts = splitLines(p, last, nc);
+
+  // Records start at non-blank lines that are not comments
+  auto record = [last](const char *l) {
+    l = skipBlanks(l, last);
+    return (l < last && *l != '\n' && *l != '#') ? l : nullptr;
+  };
+
+  // 1) Records per chunk, then index of the first record of each chunk
+  std::vector<tIndex> first(nc + 1, 0);
+  parallelFor(0, nc, [&](const tIndex c) {
+    tIndex n = 0;
+    for(const char *l = cuts[c]; l < cuts[c+1]; l = nextLine(l, last))
+      if(record(l)) ++n;
+    first[c+1] = n;
+  }, 1);
+  for(tIndex c = 0; c < nc; ++c) first[c+1] += first[c];
+  if(first[nc] < sizeV + sizeF) throw std::ios_base::failure(error);
+
+  // 2) Vertices, and triangles per chunk
+  std::vector<tIndex> tris(nc + 1, 0);
+  std::vector<char> failed(nc, 0);
+  parallelFor(0, nc, [&](const tIndex c) {
+    tIndex r = first[c], n = 0;
+    for(const char *l = cuts[c]; l < cuts[c+1] && r < sizeV + sizeF; l = nextLine(l, last)) {
+      const char *s = record(l);
+      if(!s) continue;
+      if(r < sizeV) {
+        glm::vec3 &v = P[r];
+        for(int j = 0; j < 3; ++j) {
+          s = skipBlanks(s, last);
+          const char *e = parseFloat(s, last, v[j]);
+          if(e == s) failed[c] = 1;
+          s = e;
+        }
+      } else {
+        unsigned int k = 0;
+        if(parseUInt(s, last, k) == s || k < 3) failed[c] = 1;
+        else n += k - 2;
+      }
+      ++r;
+    }
+    tris[c+1] = n;
+  }, 1);
+  for(tIndex c = 0; c < nc; ++c) {
+    if(failed[c]) throw std::ios_base::failure(error);
+    tris[c+1] += tris[c];
   }
-  std::cout << "]" << std::endl;
-  in.close();
+
+  // 3) Triangles
+  T.resize(tris[nc]);
+  parallelFor(0, nc, [&](const tIndex c) {
+    tIndex r = first[c], t = tris[c];
+    for(const char *l = cuts[c]; l < cuts[c+1] && r < sizeV + sizeF; l = nextLine(l, last)) {
+      const char *s = record(l);
+      if(!s) continue;
+      if(r++ < sizeV) continue;
+      unsigned int k = 0, i0 = 0, prev = 0, cur = 0;
+      s = parseUInt(s, last, k);
+      for(unsigned int j = 0; j < k; ++j) {
+        s = skipBlanks(s, last);
+        const char *e = parseUInt(s, last, cur);
+        if(e == s || cur >= sizeV) failed[c] = 1;
+        s = e;
+        if(j == 0) i0 = cur;
+        else if(j >= 2) T[t++] = glm::uvec3(i0, prev, cur);
+        prev = cur;
+      }
+    }
+  }, 1);
+  for(tIndex c = 0; c < nc; ++c)
+    if(failed[c]) throw std::ios_base::failure(error);
+
   meshPtr->vertexNormals().resize(P.size(), glm::vec3(0.f, 0.f, 1.f));
   meshPtr->vertexTexCoords().resize(P.size(), glm::vec2(0.f, 0.f));
   meshPtr->recomputePerVertexNormals();
   meshPtr->recomputePerVertexTextureCoordinates();
   std::cout << " > Mesh <" << filename << "> loaded" <<  std::endl;
 }
+
+void loadMesh(const std::string &filename, std::shared_ptr<Mesh> meshPtr)
+{
+  const size_t dot = filename.find_last_of('.');
+  std::string ext = (dot == std::string::npos) ? "" : filename.substr(dot + 1);
+  std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) {
+    return static_cast<char>(std::tolower(c));
+  });
+  if(ext == "off")
+    loadOFF(filename, meshPtr);
+  else if(ext == "obj")
+    loadOBJ(filename, meshPtr);
+  else if(ext == "ply")
+    loadPLY(filename, meshPtr);
+  else if(ext == "rsm")
+    loadMeshCache(filename, meshPtr);
+  else
+    throw std::ios_base::failure("[Mesh Loader][loadMesh] Unsupported format " + filename);
+}
+
+void writeMeshCache(const Mesh &mesh, const std::string &cacheFile, const std::string &sourceFile)
+{
+  MeshCacheHeader h;
+  std::memset(&h, 0, sizeof(h));
+  std::memcpy(h.magic, "RSMESH", 6);
+  h.version = MeshCacheHeader::VERSION;
+  h.endianMark = MeshCacheHeader::ENDIAN_MARK;
+  h.alignment = MeshCacheHeader::ALIGNMENT;
+  if(!sourceFile.empty()) {
+    if(!fileStamp(sourceFile, h.sourceSize, h.sourceMtime))
+      throw std::ios_base::failure("[Mesh Loader][writeMeshCache] Cannot open " + sourceFile);
+    const MappedFile source(sourceFile);
+    h.sourceHash = fnv1a(source.data(), source.size());
+  }
+
+  h.vertexCount = mesh.vertexPositions().size();
+  h.normalCount = mesh.vertexNormals().size();
+  h.texCoordCount = mesh.vertexTexCoords().size();
+  h.triangleCount = mesh.triangleIndices().size();
+  const uint64_t a = MeshCacheHeader::ALIGNMENT;
+  auto align = [a](const uint64_t x) { return (x + a - 1)/a*a; };
+  h.positionOffset = align(sizeof(h));
+  h.normalOffset = align(h.positionOffset + h.vertexCount*sizeof(glm::vec3));
+  h.texCoordOffset = align(h.normalOffset + h.normalCount*sizeof(glm::vec3));
+  h.indexOffset = align(h.texCoordOffset + h.texCoordCount*sizeof(glm::vec2));
+
+  // Write to a temporary file and rename it, so that readers never see a
+  // partial cache
+  const std::string tmp = cacheFile + ".tmp";
+  {
+    std::ofstream out(tmp.c_str(), std::ios::binary | std::ios::trunc);
+    if(!out)
+      throw std::ios_base::failure("[Mesh Loader][writeMeshCache] Cannot write " + tmp);
+    uint64_t pos = 0;
+    auto block = [&](const uint64_t offset, const void *data, const uint64_t size) {
+      static const char zeros[MeshCacheHeader::ALIGNMENT] = {0};
+      out.write(zeros, offset - pos);
+      if(size) out.write(static_cast<const char *>(data), size);
+      pos = offset + size;
+    };
+    block(0, &h, sizeof(h));
+    block(h.positionOffset, mesh.vertexPositions().data(), h.vertexCount*sizeof(glm::vec3));
+    block(h.normalOffset, mesh.vertexNormals().data(), h.normalCount*sizeof(glm::vec3));
+    block(h.texCoordOffset, mesh.vertexTexCoords().data(), h.texCoordCount*sizeof(glm::vec2));
+    block(h.indexOffset, mesh.triangleIndices().data(), h.triangleCount*sizeof(glm::uvec3));
+    if(!out)
+      throw std::ios_base::failure("[Mesh Loader][writeMeshCache] Cannot write " + tmp);
+  }
+#ifdef _WIN32
+  // rename does not replace an existing file there
+  std::remove(cacheFile.c_str());
+#endif
+  if(std::rename(tmp.c_str(), cacheFile.c_str()) != 0)
+    throw std::ios_base::failure("[Mesh Loader][writeMeshCache] Cannot write " + cacheFile);
+}
+
+template<typename T>
+static void copyBlock(
+  const MappedFile &file, const uint64_t offset, const uint64_t count, std::vector<T> &v)
+{
+  v.resize(count);
+  if(count) std::memcpy(v.data(), file.data() + offset, count*sizeof(T));
+}
+
+void loadMeshCache(const std::string &cacheFile, std::shared_ptr<Mesh> meshPtr)
+{
+  meshPtr->clear();
+  const MappedFile file(cacheFile);
+  MeshCacheHeader h;
+  if(file.size() < sizeof(h))
+    throw std::ios_base::failure("[Mesh Loader][loadMeshCache] Invalid cache " + cacheFile);
+  std::memcpy(&h, file.data(), sizeof(h));
+  if(!h.valid(file.size()) || !h.indicesValid(file.data()))
+    throw std::ios_base::failure("[Mesh Loader][loadMeshCache] Invalid cache " + cacheFile);
+
+  copyBlock(file, h.positionOffset, h.vertexCount, meshPtr->vertexPositions());
+  copyBlock(file, h.normalOffset, h.normalCount, meshPtr->vertexNormals());
+  copyBlock(file, h.texCoordOffset, h.texCoordCount, meshPtr->vertexTexCoords());
+  copyBlock(file, h.indexOffset, h.triangleCount, meshPtr->triangleIndices());
+}
+
+bool meshCacheValid(const std::string &cacheFile, const std::string &sourceFile)
+{
+  uint64_t size, cacheSize;
+  int64_t mtime, cacheMtime;
+  if(!fileStamp(sourceFile, size, mtime) || !fileStamp(cacheFile, cacheSize, cacheMtime))
+    return false;
+
+  MeshCacheHeader h;
+  {
+    const MappedFile cache(cacheFile);
+    if(cache.size() < sizeof(h)) return false;
+    std::memcpy(&h, cache.data(), sizeof(h));
+    if(!h.valid(cache.size())) return false;
+  }
+  if(h.sourceSize != size) return false;
+  if(h.sourceMtime == mtime) return true;
+  // Touched, possibly unchanged: compare the contents
+  const MappedFile source(sourceFile);
+  return fnv1a(source.data(), source.size()) == h.sourceHash;
+}
+
+std::string updateMeshCache(const std::string &sourceFile, std::string cacheFile)
+{
+  if(cacheFile.empty()) cacheFile = sourceFile + ".rsm";
+  if(!meshCacheValid(cacheFile, sourceFile)) {
+    std::shared_ptr<Mesh> mesh = std::make_shared<Mesh>();
+    loadMesh(sourceFile, mesh);
+    optimizeMesh(mesh, true);
+    writeMeshCache(*mesh, cacheFile, sourceFile);
+  }
+  return cacheFile;
+}
@@ -28,30 +28,81 @@ public:
   // Compute the parameters of a sphere which bounds the mesh
   void computeBoundingSphere(glm::vec3 &center, float &radius) const;
 
+  // Area-weighted average of the face normals around each vertex, or
+  // weighted by the corner angles with angleBased. Uses a vertex-to-corner
+  // adjacency built on first use; call invalidateAdjacency() after editing
+  // the triangles in place.
   void recomputePerVertexNormals(bool angleBased = false);
+  void invalidateAdjacency();
   void recomputePerVertexTextureCoordinates( );
 
-  void init();
+  // Upload the geometry to the GPU as one interleaved vertex buffer.
+  // Quantized halves the normals and texture coordinates (16-bit octahedral
+  // normals, half-float texture coordinates).
+  void init(bool quantized = false);
+  // Same from a binary mesh cache, straight from a mapping of the file,
+  // leaving the CPU-side vectors empty
+  void initFromCache(const std::string &cacheFile, bool quantized = false);
   void render();
+  // Per-instance model matrices: attributes 3 to 6 (a mat4 in the shader),
+  // advancing once per instance, read from buffer starting at offset
+  void setInstanceBuffer(GLuint buffer, GLintptr offset = 0);
+  // All instances in one draw call
+  void renderInstanced(GLsizei instanceCount);
   void clear();
 
   void addPlane(const float square_half_side = 1.0f);
   void addBox(const float w, const float h, const float d);
 
 private:
+  void buildAdjacency();
+  void upload(
+    const glm::vec3 *positions, const glm::vec3 *normals, const glm::vec2 *texCoords,
+    size_t vertexCount, const glm::uvec3 *triangles, size_t triangleCount,
+    bool quantized);
+
   std::vector<glm::vec3> _vertexPositions;
   std::vector<glm::vec3> _vertexNormals;
   std::vector<glm::vec2> _vertexTexCoords;
   std::vector<glm::uvec3> _triangleIndices;
 
+  // Corners 3*t+k around each vertex, in compressed rows
+  std::vector<unsigned int> _cornerOffsets;
+  std::vector<unsigned int> _vertexCorners;
+
   GLuint _vao = 0;
-  GLuint _posVbo = 0;
-  GLuint _normalVbo = 0;
-  GLuint _texCoordVbo = 0;
+  GLuint _vbo = 0;          // Interleaved vertex attributes
   GLuint _ibo = 0;
+  GLsizei _indexCount = 0;  // Indices on the GPU
+  GLenum _indexType = GL_UNSIGNED_INT;
 };
 
 // utility: loader
 void loadOFF(const std::string &filename, std::shared_ptr<Mesh> meshPtr);
+void loadOBJ(const std::string &filename, std::shared_ptr<Mesh> meshPtr);
+void loadPLY(const std::string &filename, std::shared_ptr<Mesh> meshPtr);
+// Any supported format, by file extension
+void loadMesh(const std::string &filename, std::shared_ptr<Mesh> meshPtr);
+
+// utility: binary mesh cache
+void writeMeshCache(
+  const Mesh &mesh, const std::string &cacheFile, const std::string &sourceFile = "");
+void loadMeshCache(const std::string &cacheFile, std::shared_ptr<Mesh> meshPtr);
+// Whether cacheFile holds sourceFile: same size and modification time, or
+// else same content hash
+bool meshCacheValid(const std::string &cacheFile, const std::string &sourceFile);
+// Convert sourceFile into its cache (sourceFile + ".rsm" by default) unless
+// an up-to-date one exists. Returns the cache file name.
+std::string updateMeshCache(const std::string &sourceFile, std::string cacheFile = "");
+
+// utility: optimization
+// Reorder the triangles for the post-transform vertex cache (Forsyth) and,
+// if reduceOverdraw, sort clusters of them to draw outward-facing ones first;
+// then renumber the vertices in order of first use for fetch locality. The
+// geometry is unchanged; run it once, at load or cache time.
+void optimizeMesh(std::shared_ptr<Mesh> meshPtr, bool reduceOverdraw = false);
+// Average cache misses per triangle under a FIFO cache of cacheSize vertices
+float vertexCacheMissRatio(
+  const std::vector<glm::uvec3> &T, size_t vertexCount, unsigned int cacheSize = 16);
 
 #endif  // MESH_H
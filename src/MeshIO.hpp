@@ -0,0 +1,280 @@
+// ----------------------------------------------------------------------------
+// MeshIO.hpp
+//
+//  Created on: 18 Oct 2026
+//      Author: Kiwon Um
+//        Mail: kiwon.um@telecom-paris.fr
+//
+// Description: Memory-mapped files and text parsing for mesh loaders (DO NOT DISTRIBUTE!)
+//
+// Copyright 2020-2024 Kiwon Um
+//
+// The copyright to the computer program(s) herein is the property of Kiwon Um,
+// Telecom Paris, France. The program(s) may be used and/or copied only with
+// the written permission of Kiwon Um or in accordance with the terms and
+// conditions stipulated in the agreement/contract under which the program(s)
+// have been supplied.
+// ----------------------------------------------------------------------------
+
+#ifndef _MESHIO_HPP_
+#define _MESHIO_HPP_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <ios>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <fstream>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Read-only view of a whole file. The file is memory-mapped where
+// available, so parsers read the page cache directly; elsewhere it is read
+// into memory once.
+class MappedFile {
+public:
+  explicit MappedFile(const std::string &filename) : _data(nullptr), _size(0) {
+#ifdef _WIN32
+    std::ifstream in(filename.c_str(), std::ios::binary | std::ios::ate);
+    if(!in)
+      throw std::ios_base::failure("[MappedFile] Cannot open " + filename);
+    _buffer.resize(static_cast<std::size_t>(in.tellg()));
+    in.seekg(0);
+    in.read(_buffer.data(), _buffer.size());
+    _data = _buffer.data();
+    _size = _buffer.size();
+#else
+    const int fd = ::open(filename.c_str(), O_RDONLY);
+    if(fd < 0)
+      throw std::ios_base::failure("[MappedFile] Cannot open " + filename);
+    struct stat st;
+    if(::fstat(fd, &st) != 0) {
+      ::close(fd);
+      throw std::ios_base::failure("[MappedFile] Cannot stat " + filename);
+    }
+    _size = static_cast<std::size_t>(st.st_size);
+    if(_size) {
+      void *p = ::mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if(p == MAP_FAILED) {
+        ::close(fd);
+        throw std::ios_base::failure("[MappedFile] Cannot map " + filename);
+      }
+      // The whole file is about to be read, by several threads
+      ::madvise(p, _size, MADV_WILLNEED);
+      _data = static_cast<const char *>(p);
+    }
+    ::close(fd);   // The mapping keeps the file alive
+#endif
+  }
+  ~MappedFile() {
+#ifndef _WIN32
+    if(_data) ::munmap(const_cast<char *>(_data), _size);
+#endif
+  }
+  MappedFile(const MappedFile &) = delete;
+  MappedFile& operator=(const MappedFile &) = delete;
+
+  const char* data() const { return _data; }
+  const char* end() const { return _data + _size; }
+  std::size_t size() const { return _size; }
+
+private:
+  const char *_data;
+  std::size_t _size;
+#ifdef _WIN32
+  std::vector<char> _buffer;
+#endif
+};
+
+// Number parsing in the style of std::from_chars (C++17): parse the number
+// starting exactly at first, without allocation, locale or NUL terminator.
+// Return the pointer past the number, or first when there is none.
+inline const char* parseUInt(const char *first, const char *last, unsigned int &value)
+{
+  const char *p = first;
+  std::uint64_t v = 0;
+  while(p < last && static_cast<unsigned>(*p - '0') < 10 && v <= 0xffffffffULL)
+    v = v*10 + (*p++ - '0');
+  if(p == first || v > 0xffffffffULL) return first;
+  value = static_cast<unsigned int>(v);
+  return p;
+}
+
+inline const char* parseFloat(const char *first, const char *last, float &value)
+{
+  // Exactly representable powers of ten in double
+  static const double pow10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+  const char *p = first;
+  const bool negative = (p < last && *p == '-');
+  if(p < last && (*p == '-' || *p == '+')) ++p;
+
+  // Up to 19 significant digits in the mantissa; the rest only scale
+  std::uint64_t m = 0;
+  int digits = 0, exponent = 0;
+  bool any = false;
+  for(; p < last && static_cast<unsigned>(*p - '0') < 10; ++p, any = true) {
+    if(digits < 19) { m = m*10 + (*p - '0'); if(m) ++digits; }
+    else ++exponent;
+  }
+  if(p < last && *p == '.') {
+    for(++p; p < last && static_cast<unsigned>(*p - '0') < 10; ++p, any = true) {
+      if(digits < 19) { m = m*10 + (*p - '0'); if(m) ++digits; --exponent; }
+    }
+  }
+  if(!any) {
+    // inf, nan and other rare spellings go through the C library
+    char buf[64];
+    std::size_t n = 0;
+    while(first + n < last && n + 1 < sizeof(buf) &&
+          first[n] > ' ' && first[n] != '#') {
+      buf[n] = first[n];
+      ++n;
+    }
+    buf[n] = 0;
+    char *end;
+    value = std::strtof(buf, &end);
+    return first + (end - buf);
+  }
+  if(p < last && (*p == 'e' || *p == 'E')) {
+    const char *q = p + 1;
+    const bool eneg = (q < last && *q == '-');
+    if(q < last && (*q == '-' || *q == '+')) ++q;
+    int e = 0;
+    const char *qd = q;
+    for(; q < last && static_cast<unsigned>(*q - '0') < 10; ++q)
+      e = std::min(e*10 + (*q - '0'), 100000);
+    if(q != qd) {
+      exponent += eneg ? -e : e;
+      p = q;
+    }
+  }
+
+  double v = static_cast<double>(m);
+  if(exponent >= -22 && exponent <= 22)
+    v = exponent < 0 ? v/pow10[-exponent] : v*pow10[exponent];
+  else
+    v *= std::pow(10.0, exponent);
+  value = static_cast<float>(negative ? -v : v);
+  return p;
+}
+
+// Whitespace within a line, i.e., not the newline
+inline const char* skipBlanks(const char *p, const char *last)
+{
+  while(p < last && (*p == ' ' || *p == '\t' || *p == '\r')) ++p;
+  return p;
+}
+
+inline const char* nextLine(const char *p, const char *last)
+{
+  while(p < last && *p != '\n') ++p;
+  return p < last ? p + 1 : last;
+}
+
+// Split [first, last) into about n chunks of whole lines. Returns the n+1
+// boundaries, each at the beginning of a line.
+inline std::vector<const char *> splitLines(
+  const char *first, const char *last, const std::size_t n)
+{
+  std::vector<const char *> cuts(1, first);
+  const std::size_t size = last - first;
+  for(std::size_t k = 1; k < n; ++k) {
+    const char *p = first + size*k/n;
+    p = (p > cuts.back()) ? nextLine(p - 1, last) : cuts.back();
+    cuts.push_back(p);
+  }
+  cuts.push_back(last);
+  return cuts;
+}
+
+// Size and modification time of a file; false if it does not exist
+inline bool fileStamp(const std::string &filename, std::uint64_t &size, std::int64_t &mtime)
+{
+  struct stat st;
+  if(::stat(filename.c_str(), &st) != 0) return false;
+  size = static_cast<std::uint64_t>(st.st_size);
+  // In nanoseconds where the system provides them
+#if defined(__linux__)
+  mtime = static_cast<std::int64_t>(st.st_mtim.tv_sec)*1000000000 + st.st_mtim.tv_nsec;
+#elif defined(__APPLE__)
+  mtime = static_cast<std::int64_t>(st.st_mtimespec.tv_sec)*1000000000 + st.st_mtimespec.tv_nsec;
+#else
+  mtime = static_cast<std::int64_t>(st.st_mtime)*1000000000;
+#endif
+  return true;
+}
+
+// FNV-1a hash of a byte range
+inline std::uint64_t fnv1a(const char *data, const std::size_t size)
+{
+  std::uint64_t h = 14695981039346656037ULL;
+  for(std::size_t i = 0; i < size; ++i) {
+    h ^= static_cast<unsigned char>(data[i]);
+    h *= 1099511628211ULL;
+  }
+  return h;
+}
+
+// Binary mesh cache: this header, then the position, normal, texture
+// coordinate and index blocks, each starting at a multiple of alignment so
+// they can be handed to the GPU straight from a mapping of the file. The
+// source stamp allows detecting stale caches. Native byte order.
+struct MeshCacheHeader {
+  static const std::uint32_t VERSION = 1;
+  static const std::uint32_t ENDIAN_MARK = 0x01020304;
+  static const std::uint32_t ALIGNMENT = 64;
+
+  char magic[8];                 // "RSMESH" and two zeros
+  std::uint32_t version;
+  std::uint32_t endianMark;     // Detects byte order mismatches
+  std::uint32_t alignment;
+  std::uint32_t reserved;
+  std::uint64_t sourceSize;      // Source file size in bytes
+  std::int64_t sourceMtime;      // Source modification time
+  std::uint64_t sourceHash;      // FNV-1a of the source file
+  std::uint64_t vertexCount, normalCount, texCoordCount, triangleCount;
+  std::uint64_t positionOffset, normalOffset, texCoordOffset, indexOffset;
+
+  // Header consistent with a file of fileSize bytes: every block aligned
+  // and inside the file, without overflowing on corrupt counts
+  bool valid(const std::size_t fileSize) const {
+    return std::string(magic, 6) == "RSMESH" && version == VERSION &&
+      endianMark == ENDIAN_MARK && alignment == ALIGNMENT &&
+      blockFits(positionOffset, vertexCount, 12, fileSize) &&
+      blockFits(normalOffset, normalCount, 12, fileSize) &&
+      blockFits(texCoordOffset, texCoordCount, 8, fileSize) &&
+      blockFits(indexOffset, triangleCount, 12, fileSize);
+  }
+
+  // All triangle indices below vertexCount, given the start of a file for
+  // which valid() holds
+  bool indicesValid(const char *data) const {
+    const std::uint32_t *index = reinterpret_cast<const std::uint32_t *>(data + indexOffset);
+    std::uint32_t maxIndex = 0;
+    for(std::uint64_t i = 0; i < 3*triangleCount; ++i)
+      maxIndex = std::max(maxIndex, index[i]);
+    return !triangleCount || maxIndex < vertexCount;
+  }
+
+private:
+  static bool blockFits(
+    const std::uint64_t offset, const std::uint64_t count, const std::uint64_t size,
+    const std::uint64_t fileSize) {
+    return offset % ALIGNMENT == 0 && offset <= fileSize &&
+      count <= (fileSize - offset)/size;
+  }
+};
+
+#endif  /* _MESHIO_HPP_ */
@@ -0,0 +1,717 @@
+#include "Mesh.h"
+#include "MeshIO.hpp"
+#include "Parallel.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <ios>
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+const unsigned int NONE = std::numeric_limits<unsigned int>::max();
+
+// Number of chunks for a text body of the given size
+tIndex chunkCount(const std::size_t size)
+{
+  return static_cast<tIndex>(std::max<std::size_t>(
+    1, std::min<std::size_t>(4*threadCount(), size >> 16)));
+}
+
+void throwIf(const std::vector<char> &failed, const std::string &error)
+{
+  for(const char f : failed)
+    if(f) throw std::ios_base::failure(error);
+}
+
+// Fill in what the file did not provide, as loadOFF does
+void completeAttributes(Mesh &mesh, const bool hasNormals, const bool hasTexCoords)
+{
+  const size_t n = mesh.vertexPositions().size();
+  if(!hasNormals) {
+    mesh.vertexNormals().resize(n, glm::vec3(0.f, 0.f, 1.f));
+    mesh.recomputePerVertexNormals();
+  }
+  if(!hasTexCoords) {
+    mesh.vertexTexCoords().resize(n, glm::vec2(0.f, 0.f));
+    mesh.recomputePerVertexTextureCoordinates();
+  }
+}
+
+// ---------------------------------------------------------------------------
+// Vertex deduplication
+
+// Exact bit pattern of a vertex with all its attributes
+struct VertexKey {
+  std::uint32_t bits[8];
+
+  bool operator==(const VertexKey &o) const {
+    return std::memcmp(bits, o.bits, sizeof(bits)) == 0;
+  }
+};
+
+struct VertexKeyHash {
+  std::size_t operator()(const VertexKey &k) const {
+    std::uint64_t h = 14695981039346656037ULL;
+    for(const std::uint32_t b : k.bits) {
+      h ^= b;
+      h *= 1099511628211ULL;
+    }
+    return static_cast<std::size_t>(h ^ (h >> 32));
+  }
+};
+
+// Merge vertices whose position, normal and texture coordinates are
+// identical, e.g., from exporters writing every face separately. Leaves the
+// mesh untouched when there are no duplicates.
+void weldVertices(Mesh &mesh)
+{
+  std::vector<glm::vec3> &P = mesh.vertexPositions();
+  std::vector<glm::vec3> &N = mesh.vertexNormals();
+  std::vector<glm::vec2> &UV = mesh.vertexTexCoords();
+  const size_t n = P.size();
+  const bool hasN = (N.size() == n), hasUV = (UV.size() == n);
+
+  std::vector<unsigned int> remap(n);
+  std::unordered_map<VertexKey, unsigned int, VertexKeyHash> unique;
+  unique.reserve(n);
+  unsigned int count = 0;
+  for(size_t i = 0; i < n; ++i) {
+    VertexKey k;
+    std::memset(k.bits, 0, sizeof(k.bits));
+    std::memcpy(k.bits, &P[i], sizeof(glm::vec3));
+    if(hasN) std::memcpy(k.bits + 3, &N[i], sizeof(glm::vec3));
+    if(hasUV) std::memcpy(k.bits + 6, &UV[i], sizeof(glm::vec2));
+    auto ins = unique.insert(std::make_pair(k, count));
+    remap[i] = ins.first->second;
+    if(ins.second) {
+      // Compact in place: first occurrences keep their order
+      P[count] = P[i];
+      if(hasN) N[count] = N[i];
+      if(hasUV) UV[count] = UV[i];
+      ++count;
+    }
+  }
+  if(count == n) return;
+
+  P.resize(count);
+  if(hasN) N.resize(count);
+  if(hasUV) UV.resize(count);
+  std::vector<glm::uvec3> &T = mesh.triangleIndices();
+  parallelFor(0, static_cast<tIndex>(T.size()), [&](const tIndex t) {
+    T[t] = glm::uvec3(remap[T[t][0]], remap[T[t][1]], remap[T[t][2]]);
+  }, 4096);
+}
+
+// ---------------------------------------------------------------------------
+// OBJ
+
+// A face corner: indices of its position, texture coordinates and normal
+struct Corner {
+  unsigned int v, t, n;
+
+  bool operator==(const Corner &o) const { return v == o.v && t == o.t && n == o.n; }
+};
+
+struct CornerHash {
+  std::size_t operator()(const Corner &c) const {
+    std::uint64_t h = c.v;
+    h = h*0x9E3779B97F4A7C15ULL ^ c.t;
+    h = h*0x9E3779B97F4A7C15ULL ^ c.n;
+    return static_cast<std::size_t>(h ^ (h >> 29));
+  }
+};
+
+enum ObjRecord { OBJ_NONE, OBJ_V, OBJ_VT, OBJ_VN, OBJ_F };
+
+// Kind of the line at l; s receives the start of its data
+ObjRecord objRecord(const char *l, const char *last, const char *&s)
+{
+  l = skipBlanks(l, last);
+  if(last - l < 2) return OBJ_NONE;
+  auto blank = [](const char c) { return c == ' ' || c == '\t'; };
+  if(l[0] == 'f' && blank(l[1])) { s = l + 2; return OBJ_F; }
+  if(l[0] != 'v') return OBJ_NONE;
+  if(blank(l[1])) { s = l + 2; return OBJ_V; }
+  if(last - l < 3 || !blank(l[2])) return OBJ_NONE;
+  s = l + 3;
+  return l[1] == 't' ? OBJ_VT : (l[1] == 'n' ? OBJ_VN : OBJ_NONE);
+}
+
+// Number of vertices of the face whose data starts at s
+unsigned int objFaceSize(const char *s, const char *last)
+{
+  unsigned int k = 0;
+  for(;;) {
+    s = skipBlanks(s, last);
+    if(s == last || *s == '\n' || *s == '#') return k;
+    ++k;
+    while(s < last && *s > ' ') ++s;
+  }
+}
+
+// One OBJ index: positive from the start, negative from the current end.
+// Returns NONE when absent.
+const char* objIndex(const char *s, const char *last, const unsigned int count, unsigned int &i)
+{
+  i = NONE;
+  const bool negative = (s < last && *s == '-');
+  unsigned int v = 0;
+  const char *digits = negative ? s + 1 : s;
+  const char *e = parseUInt(digits, last, v);
+  if(e == digits) return s;
+  i = negative ? (v <= count ? count - v : NONE) : (v ? v - 1 : NONE);
+  return e;
+}
+
+}  // namespace
+
+// Loads a Wavefront OBJ file: positions, texture coordinates, normals and
+// polygonal faces (fanned into triangles); everything else is ignored.
+// Chunks of lines are parsed in parallel as in loadOFF: records are counted
+// per chunk first, so each chunk knows where its vertices and triangles go
+// and can resolve relative indices. Corners are then merged into vertices
+// by hashing their (position, texture, normal) index triplets.
+void loadOBJ(const std::string &filename, std::shared_ptr<Mesh> meshPtr)
+{
+  std::cout << " > Start loading mesh <" << filename << ">" << std::endl;
+  meshPtr->clear();
+  const MappedFile file(filename);
+  const char *first = file.data(), *last = file.end();
+  const std::string error = "[Mesh Loader][loadOBJ] Invalid file " + filename;
+
+  const tIndex nc = chunkCount(file.size());
+  const std::vector<const char *> cuts = splitLines(first, last, nc);
+
+  // 1) Records per chunk, then the offsets of each chunk
+  struct Counts { tIndex v, vt, vn, tri; };
+  std::vector<Counts> off(nc + 1, Counts{0, 0, 0, 0});
+  parallelFor(0, nc, [&](const tIndex c) {
+    Counts n = {0, 0, 0, 0};
+    for(const char *l = cuts[c]; l < cuts[c+1]; l = nextLine(l, last)) {
+      const char *s;
+      switch(objRecord(l, last, s)) {
+      case OBJ_V: ++n.v; break;
+      case OBJ_VT: ++n.vt; break;
+      case OBJ_VN: ++n.vn; break;
+      case OBJ_F: n.tri += std::max(objFaceSize(s, last), 2u) - 2; break;
+      default: break;
+      }
+    }
+    off[c+1] = n;
+  }, 1);
+  for(tIndex c = 0; c < nc; ++c) {
+    off[c+1].v += off[c].v;
+    off[c+1].vt += off[c].vt;
+    off[c+1].vn += off[c].vn;
+    off[c+1].tri += off[c].tri;
+  }
+  const Counts total = off[nc];
+
+  // 2) Parse in place; positions go directly to the mesh
+  std::vector<glm::vec3> &P = meshPtr->vertexPositions();
+  std::vector<glm::vec2> uv(total.vt);
+  std::vector<glm::vec3> normals(total.vn);
+  std::vector<Corner> corners(3*static_cast<size_t>(total.tri));
+  P.resize(total.v);
+  std::vector<char> failed(nc, 0);
+  parallelFor(0, nc, [&](const tIndex c) {
+    Counts k = off[c];
+    std::vector<Corner> face;
+    for(const char *l = cuts[c]; l < cuts[c+1]; l = nextLine(l, last)) {
+      const char *s;
+      const ObjRecord r = objRecord(l, last, s);
+      if(r == OBJ_V || r == OBJ_VN || r == OBJ_VT) {
+        float x[3] = {0, 0, 0};
+        const int dim = (r == OBJ_VT) ? 2 : 3;
+        for(int j = 0; j < dim; ++j) {
+          s = skipBlanks(s, last);
+          const char *e = parseFloat(s, last, x[j]);
+          if(e == s) failed[c] = 1;
+          s = e;
+        }
+        if(r == OBJ_V) P[k.v++] = glm::vec3(x[0], x[1], x[2]);
+        else if(r == OBJ_VN) normals[k.vn++] = glm::vec3(x[0], x[1], x[2]);
+        else uv[k.vt++] = glm::vec2(x[0], x[1]);
+      } else if(r == OBJ_F) {
+        face.clear();
+        for(;;) {
+          s = skipBlanks(s, last);
+          if(s == last || *s == '\n' || *s == '#') break;
+          Corner q;
+          s = objIndex(s, last, k.v, q.v);
+          q.t = q.n = NONE;
+          if(s < last && *s == '/') {
+            ++s;
+            if(s < last && *s != '/') s = objIndex(s, last, k.vt, q.t);
+            if(s < last && *s == '/') s = objIndex(s + 1, last, k.vn, q.n);
+          }
+          if(q.v >= total.v || (q.t != NONE && q.t >= total.vt) ||
+             (q.n != NONE && q.n >= total.vn) || (s < last && *s > ' ')) {
+            failed[c] = 1;
+            break;
+          }
+          face.push_back(q);
+        }
+        for(size_t j = 2; j < face.size(); ++j) {
+          Corner *t = &corners[3*static_cast<size_t>(k.tri++)];
+          t[0] = face[0];
+          t[1] = face[j-1];
+          t[2] = face[j];
+        }
+      }
+    }
+  }, 1);
+  throwIf(failed, error);
+
+  std::vector<glm::uvec3> &T = meshPtr->triangleIndices();
+  T.resize(total.tri);
+  const bool hasTexCoords = total.vt > 0, hasNormals = total.vn > 0;
+  if(!hasTexCoords && !hasNormals) {
+    // Corners are plain positions
+    parallelFor(0, total.tri, [&](const tIndex t) {
+      T[t] = glm::uvec3(corners[3*t].v, corners[3*t+1].v, corners[3*t+2].v);
+    }, 4096);
+    completeAttributes(*meshPtr, false, false);
+  } else {
+    // 3) One vertex per distinct corner
+    std::unordered_map<Corner, unsigned int, CornerHash> unique;
+    unique.reserve(corners.size()/2);
+    std::vector<Corner> vertices;
+    vertices.reserve(total.v);
+    bool allNormals = true;
+    for(size_t i = 0; i < corners.size(); ++i) {
+      auto ins = unique.insert(
+        std::make_pair(corners[i], static_cast<unsigned int>(vertices.size())));
+      if(ins.second) vertices.push_back(corners[i]);
+      T[i/3][i%3] = ins.first->second;
+      allNormals = allNormals && corners[i].n != NONE;
+    }
+
+    std::vector<glm::vec3> positions;
+    positions.swap(P);
+    const tIndex nv = static_cast<tIndex>(vertices.size());
+    P.resize(nv);
+    std::vector<glm::vec3> &N = meshPtr->vertexNormals();
+    std::vector<glm::vec2> &UV = meshPtr->vertexTexCoords();
+    N.resize(nv, glm::vec3(0.f, 0.f, 1.f));
+    UV.resize(nv, glm::vec2(0.f, 0.f));
+    parallelFor(0, nv, [&](const tIndex i) {
+      const Corner &q = vertices[i];
+      P[i] = positions[q.v];
+      if(q.n != NONE) N[i] = normals[q.n];
+      if(q.t != NONE) UV[i] = uv[q.t];
+    }, 4096);
+    // Corners without a normal make all normals recomputed
+    completeAttributes(*meshPtr, allNormals, hasTexCoords);
+  }
+  std::cout << " > Mesh <" << filename << "> loaded" <<  std::endl;
+}
+
+namespace {
+
+// ---------------------------------------------------------------------------
+// PLY
+
+enum PlyType { PLY_INT8, PLY_UINT8, PLY_INT16, PLY_UINT16, PLY_INT32, PLY_UINT32,
+               PLY_FLOAT32, PLY_FLOAT64, PLY_INVALID };
+
+PlyType plyType(const std::string &s)
+{
+  if(s == "char" || s == "int8") return PLY_INT8;
+  if(s == "uchar" || s == "uint8") return PLY_UINT8;
+  if(s == "short" || s == "int16") return PLY_INT16;
+  if(s == "ushort" || s == "uint16") return PLY_UINT16;
+  if(s == "int" || s == "int32") return PLY_INT32;
+  if(s == "uint" || s == "uint32") return PLY_UINT32;
+  if(s == "float" || s == "float32") return PLY_FLOAT32;
+  if(s == "double" || s == "float64") return PLY_FLOAT64;
+  return PLY_INVALID;
+}
+
+size_t plySize(const PlyType t)
+{
+  static const size_t sizes[] = {1, 1, 2, 2, 4, 4, 4, 8, 0};
+  return sizes[t];
+}
+
+// One binary scalar, byte-swapped if needed
+double plyRead(const char *p, const PlyType t, const bool swap)
+{
+  unsigned char b[8];
+  const size_t n = plySize(t);
+  for(size_t i = 0; i < n; ++i) b[i] = p[swap ? n - 1 - i : i];
+  switch(t) {
+  case PLY_INT8: { std::int8_t v; std::memcpy(&v, b, 1); return v; }
+  case PLY_UINT8: return b[0];
+  case PLY_INT16: { std::int16_t v; std::memcpy(&v, b, 2); return v; }
+  case PLY_UINT16: { std::uint16_t v; std::memcpy(&v, b, 2); return v; }
+  case PLY_INT32: { std::int32_t v; std::memcpy(&v, b, 4); return v; }
+  case PLY_UINT32: { std::uint32_t v; std::memcpy(&v, b, 4); return v; }
+  case PLY_FLOAT32: { float v; std::memcpy(&v, b, 4); return v; }
+  case PLY_FLOAT64: { double v; std::memcpy(&v, b, 8); return v; }
+  default: return 0;
+  }
+}
+
+struct PlyProperty {
+  std::string name;
+  PlyType type;
+  PlyType countType;   // PLY_INVALID for scalars
+};
+
+struct PlyElement {
+  std::string name;
+  size_t count;
+  std::vector<PlyProperty> props;
+
+  // Record size in bytes, 0 when there are lists
+  size_t stride() const {
+    size_t s = 0;
+    for(const PlyProperty &p : props) {
+      if(p.countType != PLY_INVALID) return 0;
+      s += plySize(p.type);
+    }
+    return s;
+  }
+  int find(const char *name) const {
+    for(size_t i = 0; i < props.size(); ++i)
+      if(props[i].name == name) return static_cast<int>(i);
+    return -1;
+  }
+};
+
+// Vertex attributes: property index of each component, or -1
+struct PlyVertexLayout {
+  int pos[3], normal[3], uv[2];
+
+  explicit PlyVertexLayout(const PlyElement &e) {
+    const char *p[3] = {"x", "y", "z"}, *n[3] = {"nx", "ny", "nz"};
+    for(int i = 0; i < 3; ++i) {
+      pos[i] = e.find(p[i]);
+      normal[i] = e.find(n[i]);
+    }
+    const char *u[4] = {"u", "s", "texture_u", "texture_s"};
+    const char *v[4] = {"v", "t", "texture_v", "texture_t"};
+    uv[0] = uv[1] = -1;
+    for(int i = 0; i < 4 && uv[0] < 0; ++i) {
+      uv[0] = e.find(u[i]);
+      uv[1] = e.find(v[i]);
+      if(uv[1] < 0) uv[0] = -1;
+    }
+  }
+  bool hasNormals() const { return normal[0] >= 0 && normal[1] >= 0 && normal[2] >= 0; }
+  bool hasTexCoords() const { return uv[0] >= 0; }
+
+  // Store property j of vertex i
+  void set(Mesh &mesh, const size_t i, const int j, const float x) const {
+    for(int d = 0; d < 3; ++d) {
+      if(pos[d] == j) mesh.vertexPositions()[i][d] = x;
+      if(normal[d] == j) mesh.vertexNormals()[i][d] = x;
+    }
+    for(int d = 0; d < 2; ++d)
+      if(uv[d] == j) mesh.vertexTexCoords()[i][d] = x;
+  }
+};
+
+int plyFaceList(const PlyElement &e)
+{
+  const int i = e.find("vertex_indices");
+  return i >= 0 ? i : e.find("vertex_index");
+}
+
+// Binary face records, when every face is a triangle and the record size is
+// therefore fixed. Returns false, with nothing written, otherwise; size
+// receives the size of the element in bytes.
+bool plyReadTrianglesFixed(
+  const char *p, const char *last, const PlyElement &e, const bool swap,
+  std::vector<glm::uvec3> &T, size_t &size)
+{
+  const int list = plyFaceList(e);
+  size_t stride = 0, listOffset = 0;
+  for(size_t j = 0; j < e.props.size(); ++j) {
+    const PlyProperty &q = e.props[j];
+    if(static_cast<int>(j) == list) {
+      listOffset = stride;
+      stride += plySize(q.countType) + 3*plySize(q.type);
+    } else if(q.countType != PLY_INVALID) {
+      return false;
+    } else {
+      stride += plySize(q.type);
+    }
+  }
+  size = stride*e.count;
+  if(static_cast<size_t>(last - p) < size) return false;
+
+  const PlyProperty &q = e.props[list];
+  const size_t cs = plySize(q.countType), is = plySize(q.type);
+  T.resize(e.count);
+  std::atomic<bool> ok(true);
+  parallelForRange(0, static_cast<tIndex>(e.count), [&](const tIndex b, const tIndex end) {
+    bool good = true;
+    for(tIndex f = b; f < end; ++f) {
+      const char *r = p + f*stride + listOffset;
+      good = good && plyRead(r, q.countType, swap) == 3;
+      for(int k = 0; k < 3; ++k)
+        T[f][k] = static_cast<unsigned int>(plyRead(r + cs + k*is, q.type, swap));
+    }
+    if(!good) ok = false;
+  }, 4096);
+  if(!ok) T.clear();
+  return ok;
+}
+
+}  // namespace
+
+// Loads a PLY file, ASCII or binary of either byte order. Vertex positions,
+// normals and texture coordinates are read from the vertex element and
+// polygons (fanned into triangles) from the face element; other elements
+// and properties are skipped. Binary vertex records are random access and
+// converted in parallel; when the record is exactly three native floats
+// x, y, z, the block is taken as is. Triangle-only binary faces are
+// decoded in parallel as fixed-size records. ASCII bodies are parsed in
+// parallel chunks of lines as in loadOFF. Duplicate vertices are merged.
+void loadPLY(const std::string &filename, std::shared_ptr<Mesh> meshPtr)
+{
+  std::cout << " > Start loading mesh <" << filename << ">" << std::endl;
+  meshPtr->clear();
+  const MappedFile file(filename);
+  const char *p = file.data(), *last = file.end();
+  const std::string error = "[Mesh Loader][loadPLY] Invalid file " + filename;
+
+  // Header, line by line
+  auto word = [&](const char *&s) {
+    s = skipBlanks(s, last);
+    const char *b = s;
+    while(s < last && *s > ' ') ++s;
+    return std::string(b, s);
+  };
+  if(word(p) != "ply") throw std::ios_base::failure(error);
+  std::string format;
+  std::vector<PlyElement> elements;
+  for(p = nextLine(p, last); p < last; p = nextLine(p, last)) {
+    const char *s = p;
+    const std::string key = word(s);
+    if(key == "format") {
+      format = word(s);
+    } else if(key == "element") {
+      PlyElement e;
+      e.name = word(s);
+      unsigned int n = 0;
+      s = skipBlanks(s, last);
+      if(parseUInt(s, last, n) == s) throw std::ios_base::failure(error);
+      e.count = n;
+      elements.push_back(e);
+    } else if(key == "property") {
+      if(elements.empty()) throw std::ios_base::failure(error);
+      PlyProperty q;
+      q.countType = PLY_INVALID;
+      std::string t = word(s);
+      if(t == "list") {
+        q.countType = plyType(word(s));
+        if(q.countType == PLY_INVALID) throw std::ios_base::failure(error);
+        t = word(s);
+      }
+      q.type = plyType(t);
+      q.name = word(s);
+      if(q.type == PLY_INVALID) throw std::ios_base::failure(error);
+      elements.back().props.push_back(q);
+    } else if(key == "end_header") {
+      p = nextLine(p, last);
+      break;
+    }
+  }
+
+  const bool ascii = (format == "ascii");
+  const bool little = (format == "binary_little_endian");
+  if(!ascii && !little && format != "binary_big_endian")
+    throw std::ios_base::failure(error);
+  const std::uint16_t probe = 1;
+  const bool hostLittle = (*reinterpret_cast<const unsigned char *>(&probe) == 1);
+  const bool swap = !ascii && (little != hostLittle);
+
+  const PlyElement *vertexElem = nullptr, *faceElem = nullptr;
+  for(const PlyElement &e : elements) {
+    if(e.name == "vertex") vertexElem = &e;
+    if(e.name == "face") faceElem = &e;
+  }
+  if(!vertexElem || (faceElem && plyFaceList(*faceElem) < 0))
+    throw std::ios_base::failure(error);
+  const PlyVertexLayout layout(*vertexElem);
+  if(layout.pos[0] < 0 || layout.pos[1] < 0 || layout.pos[2] < 0)
+    throw std::ios_base::failure(error);
+
+  std::vector<glm::vec3> &P = meshPtr->vertexPositions();
+  std::vector<glm::uvec3> &T = meshPtr->triangleIndices();
+  const size_t nv = vertexElem->count;
+  P.resize(nv);
+  if(layout.hasNormals()) meshPtr->vertexNormals().resize(nv);
+  if(layout.hasTexCoords()) meshPtr->vertexTexCoords().resize(nv);
+
+  if(ascii) {
+    // Records of all elements follow each other, one per line
+    const tIndex nc = chunkCount(last - p);
+    const std::vector<const char *> cuts = splitLines(p, last, nc);
+    auto record = [last](const char *l) {
+      l = skipBlanks(l, last);
+      return (l < last && *l != '\n') ? l : nullptr;
+    };
+    std::vector<size_t> elemFirst(1, 0);
+    for(const PlyElement &e : elements) elemFirst.push_back(elemFirst.back() + e.count);
+    const size_t vFirst = elemFirst[vertexElem - elements.data()];
+    const size_t fFirst = faceElem ? elemFirst[faceElem - elements.data()] : 0;
+    const int list = faceElem ? plyFaceList(*faceElem) : -1;
+
+    // Parse the scalar values before the face list of s, leaving s on it
+    auto skipToList = [&](const char *&s) {
+      float x;
+      for(int j = 0; j < list; ++j) {
+        s = skipBlanks(s, last);
+        s = parseFloat(s, last, x);
+      }
+      s = skipBlanks(s, last);
+    };
+
+    // 1) Records per chunk
+    std::vector<size_t> first(nc + 1, 0), tris(nc + 1, 0);
+    parallelFor(0, nc, [&](const tIndex c) {
+      size_t n = 0;
+      for(const char *l = cuts[c]; l < cuts[c+1]; l = nextLine(l, last))
+        if(record(l)) ++n;
+      first[c+1] = n;
+    }, 1);
+    for(tIndex c = 0; c < nc; ++c) first[c+1] += first[c];
+    if(first[nc] < elemFirst.back()) throw std::ios_base::failure(error);
+
+    // 2) Vertices, and triangles per chunk
+    std::vector<char> failed(nc, 0);
+    parallelFor(0, nc, [&](const tIndex c) {
+      size_t r = first[c], n = 0;
+      for(const char *l = cuts[c]; l < cuts[c+1]; l = nextLine(l, last)) {
+        const char *s = record(l);
+        if(!s) continue;
+        if(r >= vFirst && r < vFirst + nv) {
+          const size_t i = r - vFirst;
+          for(size_t j = 0; j < vertexElem->props.size(); ++j) {
+            float x;
+            s = skipBlanks(s, last);
+            const char *e = parseFloat(s, last, x);
+            if(e == s) failed[c] = 1;
+            s = e;
+            layout.set(*meshPtr, i, static_cast<int>(j), x);
+          }
+        } else if(faceElem && r >= fFirst && r < fFirst + faceElem->count) {
+          skipToList(s);
+          unsigned int k = 0;
+          if(parseUInt(s, last, k) == s || k < 3) failed[c] = 1;
+          else n += k - 2;
+        }
+        ++r;
+      }
+      tris[c+1] = n;
+    }, 1);
+    throwIf(failed, error);
+    for(tIndex c = 0; c < nc; ++c) tris[c+1] += tris[c];
+
+    // 3) Triangles
+    T.resize(tris[nc]);
+    if(faceElem) {
+      parallelFor(0, nc, [&](const tIndex c) {
+        size_t r = first[c], t = tris[c];
+        for(const char *l = cuts[c]; l < cuts[c+1]; l = nextLine(l, last)) {
+          const char *s = record(l);
+          if(!s) continue;
+          const size_t i = r++;
+          if(i < fFirst || i >= fFirst + faceElem->count) continue;
+          skipToList(s);
+          unsigned int k = 0, i0 = 0, prev = 0, cur = 0;
+          s = parseUInt(s, last, k);
+          for(unsigned int j = 0; j < k; ++j) {
+            s = skipBlanks(s, last);
+            const char *e = parseUInt(s, last, cur);
+            if(e == s || cur >= nv) failed[c] = 1;
+            s = e;
+            if(j == 0) i0 = cur;
+            else if(j >= 2) T[t++] = glm::uvec3(i0, prev, cur);
+            prev = cur;
+          }
+        }
+      }, 1);
+      throwIf(failed, error);
+    }
+  } else {
+    // Elements one after the other
+    for(const PlyElement &e : elements) {
+      const size_t stride = e.stride();
+      size_t size = 0;
+      if(&e == vertexElem) {
+        if(!stride || static_cast<size_t>(last - p) < stride*nv)
+          throw std::ios_base::failure(error);
+        const bool packed = !swap && stride == sizeof(glm::vec3) &&
+          layout.pos[0] == 0 && layout.pos[1] == 1 && layout.pos[2] == 2 &&
+          e.props[0].type == PLY_FLOAT32 && e.props[1].type == PLY_FLOAT32 &&
+          e.props[2].type == PLY_FLOAT32;
+        if(packed) {
+          if(nv) std::memcpy(P.data(), p, nv*sizeof(glm::vec3));
+        } else {
+          std::vector<size_t> offsets(1, 0);
+          for(const PlyProperty &q : e.props) offsets.push_back(offsets.back() + plySize(q.type));
+          const char *base = p;
+          parallelFor(0, static_cast<tIndex>(nv), [&](const tIndex i) {
+            const char *r = base + i*stride;
+            for(size_t j = 0; j < e.props.size(); ++j)
+              layout.set(*meshPtr, i, static_cast<int>(j),
+                         static_cast<float>(plyRead(r + offsets[j], e.props[j].type, swap)));
+          }, 4096);
+        }
+        p += stride*nv;
+      } else if(stride) {
+        if(static_cast<size_t>(last - p) < stride*e.count)
+          throw std::ios_base::failure(error);
+        p += stride*e.count;
+      } else if(&e == faceElem && plyReadTrianglesFixed(p, last, e, swap, T, size)) {
+        p += size;
+      } else {
+        // Variable-size records: a serial scan, fanning faces
+        const int list = (&e == faceElem) ? plyFaceList(e) : -1;
+        for(size_t f = 0; f < e.count; ++f) {
+          for(size_t j = 0; j < e.props.size(); ++j) {
+            const PlyProperty &q = e.props[j];
+            if(q.countType == PLY_INVALID) {
+              p += plySize(q.type);
+              continue;
+            }
+            if(static_cast<size_t>(last - p) < plySize(q.countType))
+              throw std::ios_base::failure(error);
+            const size_t k = static_cast<size_t>(plyRead(p, q.countType, swap));
+            p += plySize(q.countType);
+            const size_t is = plySize(q.type);
+            if(static_cast<size_t>(last - p) < k*is) throw std::ios_base::failure(error);
+            if(static_cast<int>(j) == list) {
+              const unsigned int i0 = static_cast<unsigned int>(plyRead(p, q.type, swap));
+              for(size_t m = 2; m < k; ++m)
+                T.push_back(glm::uvec3(
+                  i0, static_cast<unsigned int>(plyRead(p + (m-1)*is, q.type, swap)),
+                  static_cast<unsigned int>(plyRead(p + m*is, q.type, swap))));
+            }
+            p += k*is;
+          }
+        }
+      }
+      if(p > last) throw std::ios_base::failure(error);
+    }
+    for(const glm::uvec3 &t : T)
+      if(t[0] >= nv || t[1] >= nv || t[2] >= nv) throw std::ios_base::failure(error);
+  }
+
+  weldVertices(*meshPtr);
+  completeAttributes(*meshPtr, layout.hasNormals(), layout.hasTexCoords());
+  std::cout << " > Mesh <" << filename << "> loaded" <<  std::endl;
+}
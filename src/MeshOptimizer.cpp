@@ -0,0 +1,236 @@
+#include "Mesh.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace {
+
+const int CACHE_SIZE = 32;      // Modeled post-transform cache
+const int MAX_VALENCE = 64;     // Beyond this the valence boost is flat
+
+// Forsyth's vertex score: recently used vertices score high, except the
+// three of the last triangle, which another triangle cannot reuse all at
+// once; vertices with few remaining triangles get a boost so that they are
+// finished off instead of left as isolated islands.
+struct ScoreTable {
+  float cache[CACHE_SIZE];
+  float valence[MAX_VALENCE + 1];
+
+  ScoreTable() {
+    for(int i = 0; i < CACHE_SIZE; ++i)
+      cache[i] = (i < 3) ? 0.75f :
+        std::pow(1.f - static_cast<float>(i - 3)/(CACHE_SIZE - 3), 1.5f);
+    valence[0] = 0;
+    for(int i = 1; i <= MAX_VALENCE; ++i)
+      valence[i] = 2.f/std::sqrt(static_cast<float>(i));
+  }
+
+  float operator()(const int cachePos, const unsigned int remaining) const {
+    if(!remaining) return -1;
+    return (cachePos >= 0 ? cache[cachePos] : 0) +
+      valence[std::min(remaining, static_cast<unsigned int>(MAX_VALENCE))];
+  }
+};
+
+// Triangles in Forsyth order, "Linear-speed vertex cache optimisation"
+std::vector<glm::uvec3> optimizeVertexCache(const std::vector<glm::uvec3> &T, const size_t nv)
+{
+  static const ScoreTable score;
+  const size_t nt = T.size();
+
+  // Live triangles of each vertex, in compressed rows; the first
+  // remaining[v] entries of a row are the triangles not emitted yet
+  std::vector<unsigned int> offsets(nv + 1, 0), remaining(nv, 0);
+  for(const glm::uvec3 &t : T)
+    for(int k = 0; k < 3; ++k) ++offsets[t[k] + 1];
+  for(size_t v = 0; v < nv; ++v) {
+    remaining[v] = offsets[v + 1];
+    offsets[v + 1] += offsets[v];
+  }
+  std::vector<unsigned int> adjacency(offsets[nv]);
+  {
+    std::vector<unsigned int> cursor(offsets.begin(), offsets.end() - 1);
+    for(unsigned int t = 0; t < nt; ++t)
+      for(int k = 0; k < 3; ++k) adjacency[cursor[T[t][k]]++] = t;
+  }
+
+  std::vector<int> cachePos(nv, -1);
+  std::vector<float> vScore(nv), tScore(nt);
+  std::vector<char> emitted(nt, 0);
+  for(size_t v = 0; v < nv; ++v) vScore[v] = score(-1, remaining[v]);
+  for(size_t t = 0; t < nt; ++t)
+    tScore[t] = vScore[T[t][0]] + vScore[T[t][1]] + vScore[T[t][2]];
+
+  std::vector<glm::uvec3> out;
+  out.reserve(nt);
+  std::vector<unsigned int> cache, next;
+  cache.reserve(CACHE_SIZE + 3);
+  next.reserve(CACHE_SIZE + 3);
+  size_t cursor = 0;   // No triangle before it is left
+  long best = std::max_element(tScore.begin(), tScore.end()) - tScore.begin();
+
+  while(out.size() < nt) {
+    if(best < 0) {
+      // Dead end: restart from the next triangle in input order
+      while(emitted[cursor]) ++cursor;
+      best = static_cast<long>(cursor);
+    }
+    const glm::uvec3 &tri = T[best];
+    emitted[best] = 1;
+    out.push_back(tri);
+
+    // Retire the triangle from its vertices and move them to the front
+    next.clear();
+    for(int k = 0; k < 3; ++k) {
+      const unsigned int v = tri[k];
+      unsigned int *row = &adjacency[offsets[v]];
+      std::swap(*std::find(row, row + remaining[v], static_cast<unsigned int>(best)),
+                row[remaining[v] - 1]);
+      --remaining[v];
+      next.push_back(v);
+    }
+    for(const unsigned int v : cache)
+      if(v != tri[0] && v != tri[1] && v != tri[2]) next.push_back(v);
+    cache.swap(next);
+
+    // Rescore the vertices in or just out of the cache and their triangles
+    for(size_t i = 0; i < cache.size(); ++i) {
+      const unsigned int v = cache[i];
+      cachePos[v] = (i < static_cast<size_t>(CACHE_SIZE)) ? static_cast<int>(i) : -1;
+      vScore[v] = score(cachePos[v], remaining[v]);
+    }
+    best = -1;
+    float bestScore = -1;
+    for(const unsigned int v : cache) {
+      for(unsigned int i = offsets[v]; i < offsets[v] + remaining[v]; ++i) {
+        const unsigned int t = adjacency[i];
+        const float s = vScore[T[t][0]] + vScore[T[t][1]] + vScore[T[t][2]];
+        tScore[t] = s;
+        if(s > bestScore) {
+          bestScore = s;
+          best = t;
+        }
+      }
+    }
+    if(cache.size() > static_cast<size_t>(CACHE_SIZE)) cache.resize(CACHE_SIZE);
+  }
+  return out;
+}
+
+// Split the sequence into clusters wherever a simulated FIFO cache misses
+// all three vertices of a triangle, i.e., where the cache order restarts,
+// then draw first the clusters facing outwards from the center, which are
+// likely to occlude the others.
+void reduceOverdraw(std::vector<glm::uvec3> &T, const std::vector<glm::vec3> &P)
+{
+  const size_t nt = T.size();
+  const unsigned int FIFO = 16;
+  std::vector<unsigned int> stamp(P.size(), 0);
+  unsigned int time = FIFO + 1;
+  std::vector<size_t> starts;
+  for(size_t t = 0; t < nt; ++t) {
+    int misses = 0;
+    for(int k = 0; k < 3; ++k) {
+      if(time - stamp[T[t][k]] > FIFO) {
+        stamp[T[t][k]] = time++;
+        ++misses;
+      }
+    }
+    if(misses == 3 || t == 0) starts.push_back(t);
+  }
+  starts.push_back(nt);
+
+  glm::vec3 center(0.f);
+  for(const glm::vec3 &p : P) center += p;
+  if(!P.empty()) center /= static_cast<float>(P.size());
+
+  // Area-weighted centroid and normal of each cluster
+  const size_t nc = starts.size() - 1;
+  std::vector<float> key(nc);
+  for(size_t c = 0; c < nc; ++c) {
+    glm::vec3 centroid(0.f), normal(0.f);
+    float area = 0;
+    for(size_t t = starts[c]; t < starts[c+1]; ++t) {
+      const glm::vec3 &a = P[T[t][0]], &b = P[T[t][1]], &d = P[T[t][2]];
+      const glm::vec3 n = glm::cross(b - a, d - a);
+      const float w = glm::length(n);
+      centroid += (a + b + d)*(w/3);
+      normal += n;
+      area += w;
+    }
+    if(area > 0) centroid /= area;
+    key[c] = glm::dot(centroid - center, normal);
+  }
+
+  std::vector<size_t> order(nc);
+  for(size_t c = 0; c < nc; ++c) order[c] = c;
+  std::stable_sort(order.begin(), order.end(), [&key](const size_t a, const size_t b) {
+    return key[a] > key[b];
+  });
+  std::vector<glm::uvec3> sorted;
+  sorted.reserve(nt);
+  for(const size_t c : order)
+    sorted.insert(sorted.end(), T.begin() + starts[c], T.begin() + starts[c+1]);
+  T.swap(sorted);
+}
+
+// Renumber the vertices in order of first use, and permute the attributes
+// accordingly; unreferenced vertices go last.
+void optimizeVertexFetch(Mesh &mesh)
+{
+  std::vector<glm::uvec3> &T = mesh.triangleIndices();
+  const size_t nv = mesh.vertexPositions().size();
+  const unsigned int NONE = static_cast<unsigned int>(-1);
+  std::vector<unsigned int> remap(nv, NONE);
+  unsigned int next = 0;
+  for(glm::uvec3 &t : T) {
+    for(int k = 0; k < 3; ++k) {
+      if(remap[t[k]] == NONE) remap[t[k]] = next++;
+      t[k] = remap[t[k]];
+    }
+  }
+  for(size_t v = 0; v < nv; ++v)
+    if(remap[v] == NONE) remap[v] = next++;
+
+  std::vector<glm::vec3> P(nv), N(mesh.vertexNormals().size());
+  std::vector<glm::vec2> UV(mesh.vertexTexCoords().size());
+  for(size_t v = 0; v < nv; ++v) {
+    P[remap[v]] = mesh.vertexPositions()[v];
+    if(N.size() == nv) N[remap[v]] = mesh.vertexNormals()[v];
+    if(UV.size() == nv) UV[remap[v]] = mesh.vertexTexCoords()[v];
+  }
+  mesh.vertexPositions().swap(P);
+  if(N.size() == nv) mesh.vertexNormals().swap(N);
+  if(UV.size() == nv) mesh.vertexTexCoords().swap(UV);
+}
+
+}  // namespace
+
+void optimizeMesh(std::shared_ptr<Mesh> meshPtr, bool reduceOverdrawToo)
+{
+  Mesh &mesh = *meshPtr;
+  std::vector<glm::uvec3> &T = mesh.triangleIndices();
+  T = optimizeVertexCache(T, mesh.vertexPositions().size());
+  if(reduceOverdrawToo)
+    reduceOverdraw(T, mesh.vertexPositions());
+  optimizeVertexFetch(mesh);
+  mesh.invalidateAdjacency();
+}
+
+float vertexCacheMissRatio(const std::vector<glm::uvec3> &T, size_t vertexCount, unsigned int cacheSize)
+{
+  if(T.empty()) return 0;
+  std::vector<unsigned int> stamp(vertexCount, 0);
+  unsigned int time = cacheSize + 1;
+  size_t misses = 0;
+  for(const glm::uvec3 &t : T) {
+    for(int k = 0; k < 3; ++k) {
+      if(time - stamp[t[k]] > cacheSize) {
+        stamp[t[k]] = time++;
+        ++misses;
+      }
+    }
+  }
+  return static_cast<float>(misses)/T.size();
+}
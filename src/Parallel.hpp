@@ -0,0 +1,225 @@
+// ----------------------------------------------------------------------------
+// Parallel.hpp
+//
+//  Created on: 18 Oct 2026
+//      Author: Kiwon Um
+//        Mail: kiwon.um@telecom-paris.fr
+//
+// Description: Minimal parallel loop helpers (DO NOT DISTRIBUTE!)
+//
+// Copyright 2020-2024 Kiwon Um
+//
+// The copyright to the computer program(s) herein is the property of Kiwon Um,
+// Telecom Paris, France. The program(s) may be used and/or copied only with
+// the written permission of Kiwon Um or in accordance with the terms and
+// conditions stipulated in the agreement/contract under which the program(s)
+// have been supplied.
+// ----------------------------------------------------------------------------
+
+#ifndef _PARALLEL_HPP_
+#define _PARALLEL_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "typedefs.hpp"
+
+inline tIndex threadCount()
+{
+  const tIndex n = std::thread::hardware_concurrency();
+  return n ? n : 1;
+}
+
+// Workers started once and kept for the whole run, so that a parallel loop
+// costs a wake-up rather than creating and joining threads. run() hands out
+// the tasks of one loop to the workers and the calling thread. Loops nested
+// in a task, or started while another thread runs one, run serially on the
+// calling thread instead of waiting for the pool.
+//
+// Each worker copies the description of a loop under the lock, and claims
+// its tasks from a counter tagged with the loop's generation: a worker
+// still holding an older loop cannot take an index of the next one, so an
+// index is always checked against the bounds of the loop it belongs to.
+class ThreadPool {
+public:
+  explicit ThreadPool(const tIndex workers)
+    : _stop(false), _generation(0), _active(0), _next(0), _pending(0)
+  {
+    for(tIndex i = 0; i < workers; ++i)
+      _threads.emplace_back([this]() { loop(); });
+  }
+
+  ~ThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _stop = true;
+    }
+    _wake.notify_all();
+    for(std::thread &t : _threads) t.join();
+  }
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool& operator=(const ThreadPool &) = delete;
+
+  // The pool shared by the parallel loops, one thread per core
+  static ThreadPool& instance() {
+    static ThreadPool pool(threadCount() - 1);
+    return pool;
+  }
+
+  // Threads taking part in a loop, the caller included
+  tIndex size() const { return static_cast<tIndex>(_threads.size()) + 1; }
+
+  // Call job(k) for every k in [0, count) and return when all are done. An
+  // exception thrown by a task is rethrown here.
+  template<typename Func>
+  void run(const tIndex count, const Func &job) {
+    std::unique_lock<std::mutex> busy(_busy, std::defer_lock);
+    if(count <= 1 || _threads.empty() || inLoop() || !busy.try_lock()) {
+      for(tIndex k = 0; k < count; ++k) job(k);
+      return;
+    }
+
+    Loop current;
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      ++_generation;
+      _loop.invoke = &invoke<Func>;
+      _loop.job = &job;
+      _loop.count = count;
+      _loop.tag = static_cast<std::uint32_t>(_generation);
+      _next = static_cast<std::uint64_t>(_loop.tag) << 32;
+      _pending = count;
+      _error = nullptr;
+      current = _loop;
+    }
+    _wake.notify_all();
+
+    inLoop() = true;
+    work(current);
+    inLoop() = false;
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    _done.wait(lock, [this]() { return _pending == 0 && _active == 0; });
+    _loop.job = nullptr;
+    if(_error) std::rethrow_exception(_error);
+  }
+
+private:
+  // One parallel loop, as copied by each thread taking part in it
+  struct Loop {
+    void (*invoke)(const void *, tIndex);
+    const void *job;
+    tIndex count;
+    std::uint32_t tag;         // Low bits of the generation
+  };
+
+  template<typename Func>
+  static void invoke(const void *job, const tIndex k) { (*static_cast<const Func *>(job))(k); }
+
+  // Whether the current thread is running tasks of a loop
+  static bool& inLoop() {
+    static thread_local bool flag = false;
+    return flag;
+  }
+
+  void loop() {
+    inLoop() = true;
+    std::size_t seen = 0;
+    for(;;) {
+      Loop current;
+      {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _wake.wait(lock, [&]() { return _stop || _generation != seen; });
+        if(_stop) return;
+        seen = _generation;
+        current = _loop;
+        ++_active;
+      }
+      work(current);
+      {
+        std::lock_guard<std::mutex> lock(_mutex);
+        --_active;
+      }
+      _done.notify_all();
+    }
+  }
+
+  // Claim and run tasks of the given loop until none is left, or until the
+  // counter belongs to another loop
+  void work(const Loop &loop) {
+    const std::uint64_t tag = static_cast<std::uint64_t>(loop.tag) << 32;
+    std::uint64_t next = _next.load();
+    for(;;) {
+      if((next & ~0xffffffffULL) != tag) return;
+      const tIndex k = static_cast<tIndex>(next);
+      if(k >= loop.count) return;
+      if(!_next.compare_exchange_weak(next, next + 1)) continue;
+      try {
+        loop.invoke(loop.job, k);
+      } catch(...) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if(!_error) _error = std::current_exception();
+      }
+      if(_pending.fetch_sub(1) == 1) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _done.notify_all();
+      }
+      next = _next.load();
+    }
+  }
+
+  std::vector<std::thread> _threads;
+  std::mutex _busy;              // Held by the thread running a loop
+  std::mutex _mutex;             // Guards the loop description below
+  std::condition_variable _wake, _done;
+  bool _stop;
+  std::size_t _generation;       // Loops started so far
+  tIndex _active;                // Workers inside work()
+
+  Loop _loop;                    // Loop of the current generation
+  std::atomic<std::uint64_t> _next;  // Generation tag and next task to claim
+  std::atomic<tIndex> _pending;  // Tasks not finished yet
+  std::exception_ptr _error;
+};
+
+// Call f(begin, end) on disjoint chunks covering [begin, end), one chunk per
+// thread of the pool. Ranges shorter than grain per thread run on the
+// calling thread.
+template<typename Func>
+void parallelForRange(
+  const tIndex begin, const tIndex end, const Func &f, const tIndex grain = 256)
+{
+  if(end <= begin) return;
+  ThreadPool &pool = ThreadPool::instance();
+  const tIndex n = end - begin;
+  const tIndex nt = std::min(pool.size(), (n + grain - 1)/grain);
+  if(nt <= 1) {
+    f(begin, end);
+    return;
+  }
+
+  const tIndex chunk = (n + nt - 1)/nt;
+  pool.run(nt, [&f, begin, end, chunk](const tIndex t) {
+    const tIndex b = begin + t*chunk, e = std::min(end, b + chunk);
+    if(b < e) f(b, e);
+  });
+}
+
+// Call f(i) for every i in [begin, end)
+template<typename Func>
+void parallelFor(
+  const tIndex begin, const tIndex end, const Func &f, const tIndex grain = 256)
+{
+  parallelForRange(begin, end, [&f](const tIndex b, const tIndex e) {
+    for(tIndex i = b; i < e; ++i) f(i);
+  }, grain);
+}
+
+#endif  /* _PARALLEL_HPP_ */
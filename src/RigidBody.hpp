@@ -0,0 +1,311 @@
+// ----------------------------------------------------------------------------
+// RigidBody.hpp
+//
+//  Created on: 18 Dec 2020
+//      Author: Kiwon Um
+//        Mail: kiwon.um@telecom-paris.fr
+//
+// Description: Rigid body attributes and shapes (DO NOT DISTRIBUTE!)
+//
+// Copyright 2020-2024 Kiwon Um
+//
+// The copyright to the computer program(s) herein is the property of Kiwon Um,
+// Telecom Paris, France. The program(s) may be used and/or copied only with
+// the written permission of Kiwon Um or in accordance with the terms and
+// conditions stipulated in the agreement/contract under which the program(s)
+// have been supplied.
+// ----------------------------------------------------------------------------
+
+#ifndef _RIGIDBODY_HPP_
+#define _RIGIDBODY_HPP_
+
+#include <glm/ext/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+#include "Vector3.hpp"
+#include "Matrix3x3.hpp"
+
+// Compile-time precision policies for the bodies, the solver and the force
+// generators. Real is used for everything but positions, which use
+// PosReal: the mixed policy keeps float throughput with double positions.
+// All policies can be used in the same binary.
+template<typename R, typename PR>
+struct PrecisionPolicy {
+  typedef R Real;
+  typedef PR PosReal;
+  typedef Vector3<Real> Vec;
+  typedef Vector3<PosReal> Pos;
+  typedef Matrix3x3<Real> Mat;
+  typedef glm::qua<Real, glm::defaultp> Quat;
+};
+
+typedef PrecisionPolicy<float, float> FloatPrecision;
+typedef PrecisionPolicy<double, double> DoublePrecision;
+typedef PrecisionPolicy<float, double> MixedPrecision;
+
+// A helper function to compute the cross product of two 3D vectors.
+// We define it here as a free function for clarity.
+template<typename T>
+inline Vector3<T> crossProduct(const Vector3<T> &a, const Vector3<T> &b)
+{
+  // Cross product: a x b
+  return Vector3<T>(
+    a[1]*b[2] - a[2]*b[1],
+    a[2]*b[0] - a[0]*b[2],
+    a[0]*b[1] - a[1]*b[0]
+  );
+}
+
+// Rotation matrix of a unit quaternion
+template<typename T>
+inline Matrix3x3<T> quatToMat3(const glm::qua<T, glm::defaultp> &q)
+{
+  // glm is column-major
+  const glm::mat<3, 3, T, glm::defaultp> rot = glm::mat3_cast(q);
+  return Matrix3x3<T>(rot[0][0], rot[1][0], rot[2][0],
+                      rot[0][1], rot[1][1], rot[2][1],
+                      rot[0][2], rot[1][2], rot[2][2]);
+}
+
+// Integer coordinates of a cell of the world grid. A body's position X is
+// relative to the center of its own cell, so it stays small, hence accurate
+// in float, however far the body is from the world origin. The cell size is
+// a power of two, so whole-cell offsets are exact.
+struct GridCell {
+  explicit GridCell(const std::int64_t x = 0, const std::int64_t y = 0, const std::int64_t z = 0)
+    : x(x), y(y), z(z) {}
+
+  static double size() { return 1024; }
+  // Cell whose center is closest to the coordinate c, in cells from here
+  static std::int64_t steps(const double c) {
+    return static_cast<std::int64_t>(std::floor(c/size() + 0.5));
+  }
+
+  bool operator==(const GridCell &c) const { return x == c.x && y == c.y && z == c.z; }
+  bool operator!=(const GridCell &c) const { return !(*this == c); }
+
+  std::int64_t x, y, z;
+};
+
+// Offset from the center of cell a to the center of cell b. The cell
+// difference is taken in integers before converting, so it is exact for
+// nearby cells whatever their distance to the world origin.
+template<typename T>
+inline Vector3<T> cellOffset(const GridCell &a, const GridCell &b)
+{
+  return Vector3<T>(static_cast<T>(static_cast<double>(b.x - a.x)*GridCell::size()),
+                    static_cast<T>(static_cast<double>(b.y - a.y)*GridCell::size()),
+                    static_cast<T>(static_cast<double>(b.z - a.z)*GridCell::size()));
+}
+
+// Dynamic state of a body, i.e., everything a step overwrites. Used to roll
+// back rejected steps.
+template<typename Policy>
+struct BodyStateT {
+  GridCell cell;
+  typename Policy::Pos X;
+  typename Policy::Vec P, L, V, omega;
+  typename Policy::Quat q;
+};
+
+template<typename Policy>
+struct BodyAttributesT {
+  typedef typename Policy::Real Real;
+  typedef typename Policy::PosReal PosReal;
+  typedef typename Policy::Vec Vec;
+  typedef typename Policy::Pos Pos;
+  typedef typename Policy::Mat Mat;
+  typedef typename Policy::Quat Quat;
+
+  BodyAttributesT()
+    : diagonalInertia(false), X(0, 0, 0), P(0, 0, 0), L(0, 0, 0),
+      V(0, 0, 0), omega(0, 0, 0), F(0, 0, 0), tau(0, 0, 0),
+      q(1, 0, 0, 0) // Initialize quaternion as identity
+  {}
+
+  // This function returns the model matrix for rendering, relative to the
+  // center of the given cell, e.g., the origin cell of the solver.
+  glm::mat4 worldMat(const GridCell &origin = GridCell()) const {
+    const Pos x = positionFrom(origin);
+    glm::mat4 m = glm::mat4_cast(glm::quat(q));
+    m[3] = glm::vec4(x[0], x[1], x[2], 1);
+    return m;
+  }
+
+  // Position relative to the center of cell c
+  Pos positionFrom(const GridCell &c) const { return X + cellOffset<PosReal>(c, cell); }
+  // Offset from this body's center of mass to the other one's
+  Vec offsetTo(const BodyAttributesT &b) const {
+    return Vec(Pos(Pos(b.X - X) + cellOffset<PosReal>(cell, b.cell)));
+  }
+
+  // Move the body to the cell containing X once it left its own cell.
+  // Returns whether it moved.
+  bool updateCell() {
+    const double half = GridCell::size()/2;
+    if(std::abs(X[0]) <= half && std::abs(X[1]) <= half && std::abs(X[2]) <= half)
+      return false;
+    const GridCell k(GridCell::steps(X[0]), GridCell::steps(X[1]), GridCell::steps(X[2]));
+    X -= cellOffset<PosReal>(GridCell(), k);
+    cell.x += k.x;
+    cell.y += k.y;
+    cell.z += k.z;
+    return true;
+  }
+
+  // The quaternion is the orientation state; the rotation matrix is only
+  // materialized on demand, e.g., for collision queries over many vertices.
+  Mat rotation() const { return quatToMat3(q); }
+
+  // Rotate a body-space vector to world space, and back
+  Vec toWorld(const Vec &v) const {
+    const Vec u(q.x, q.y, q.z);
+    const Vec uv = u.crossProduct(v);
+    return v + (uv*q.w + u.crossProduct(uv))*2;
+  }
+  Vec toBody(const Vec &v) const {
+    const Vec u(-q.x, -q.y, -q.z);
+    const Vec uv = u.crossProduct(v);
+    return v + (uv*q.w + u.crossProduct(uv))*2;
+  }
+
+  // Radius of the sphere centered at X that bounds all vertices
+  Real boundingRadius() const {
+    Real r2 = 0;
+    for(const Vec &v : vdata0) r2 = std::max(r2, v.lengthSquare());
+    return std::sqrt(r2);
+  }
+
+  BodyStateT<Policy> state() const {
+    BodyStateT<Policy> s;
+    s.cell = cell; s.X = X; s.P = P; s.L = L; s.V = V; s.omega = omega; s.q = q;
+    return s;
+  }
+  void setState(const BodyStateT<Policy> &s) {
+    cell = s.cell; X = s.X; P = s.P; L = s.L; V = s.V; omega = s.omega; q = s.q;
+  }
+
+  // Set the body-space inertia tensor. When the body frame is a principal
+  // frame, i.e., I0 is diagonal, only the principal moments are used.
+  void setInertia(const Mat &I) {
+    I0 = I;
+    diagonalInertia = I.isDiagonal();
+    I0inv = diagonalInertia ? I.diagonalInverse() : I.symmetricInverse();
+    I0diag = I.diagonal();
+    I0invDiag = I0inv.diagonal();
+  }
+
+  // Multiplication by the body-space inertia tensor and its inverse,
+  // specialized at compile time for principal frames
+  template<bool Diagonal> Vec inertiaMul(const Vec &w) const {
+    if(Diagonal) return I0diag * w;
+    return I0 * w;
+  }
+  template<bool Diagonal> Vec invInertiaMul(const Vec &l) const {
+    if(Diagonal) return I0invDiag * l;
+    return I0inv * l;
+  }
+  // A*I0
+  template<bool Diagonal> Mat matMulInertia(const Mat &A) const {
+    if(Diagonal) return A.mulDiagonal(I0diag);
+    return A * I0;
+  }
+
+  // World-space inverse inertia times a vector, R*(I0^-1*(R^T*l)), without
+  // forming R*I0^-1*R^T
+  template<bool Diagonal> Vec worldInvInertiaMul(const Vec &l) const {
+    return toWorld(invInertiaMul<Diagonal>(toBody(l)));
+  }
+  // Same with an already materialized rotation matrix
+  Vec worldInvInertiaMul(const Mat &R, const Vec &l) const {
+    return R * (diagonalInertia ?
+                invInertiaMul<true>(R.transposedMul(l)) :
+                invInertiaMul<false>(R.transposedMul(l)));
+  }
+
+  Real M;        // Mass
+  Mat I0;        // Inertia tensor in body space
+  Mat I0inv;     // Inverse of I0
+  Vec I0diag;       // Principal moments of inertia
+  Vec I0invDiag;    // Their inverses
+  bool diagonalInertia;  // Whether the body frame is a principal frame
+
+  GridCell cell;  // Cell of the world grid X is relative to
+  Pos X;         // Position, relative to the center of the cell
+  Vec P;         // Linear momentum
+  Vec L;         // Angular momentum
+
+  Vec V;         // Linear velocity
+  Vec omega;     // Angular velocity
+
+  Vec F;         // Force
+  Vec tau;       // Torque
+
+  Quat q;        // Quaternion to represent orientation
+
+  // Vertices in body space
+  std::vector<Vec> vdata0;
+};
+
+template<typename Policy>
+class BoxT : public BodyAttributesT<Policy> {
+public:
+  typedef typename Policy::Real Real;
+  typedef typename Policy::Vec Vec;
+  typedef typename Policy::Mat Mat;
+
+  explicit BoxT(
+    Real w = 1.0,
+    Real h = 1.0,
+    Real d = 1.0,
+    Real dens = 10.0,
+    const Vec v0 = Vec(0, 0, 0),
+    const Vec omega0 = Vec(0, 0, 0))
+    : width(w), height(h), depth(d)
+  {
+    // Initial linear and angular velocity
+    this->V = v0;
+    this->omega = omega0;
+
+    // Compute mass
+    const Real M = dens * w * h * d;
+    this->M = M;
+
+    // Compute inertia tensor for a box with center at (0,0,0).
+    // Ixx = (1/12)*M*(h^2 + d^2), etc.
+    const Real oneTwelfth = static_cast<Real>(1.0 / 12.0);
+    const Real Ixx = oneTwelfth * M * (h*h + d*d);
+    const Real Iyy = oneTwelfth * M * (w*w + d*d);
+    const Real Izz = oneTwelfth * M * (w*w + h*h);
+
+    // The box axes are principal axes
+    this->setInertia(Mat(Vec(Ixx, Iyy, Izz)));
+
+    // Momenta consistent with the initial velocities
+    this->P = this->V * M;
+    this->L = this->I0 * this->omega;
+
+    // Define 8 vertices in body space
+    std::vector<Vec> &vdata0 = this->vdata0;
+    vdata0.push_back(Vec(-0.5f*w, -0.5f*h, -0.5f*d));
+    vdata0.push_back(Vec( 0.5f*w, -0.5f*h, -0.5f*d));
+    vdata0.push_back(Vec( 0.5f*w,  0.5f*h, -0.5f*d));
+    vdata0.push_back(Vec(-0.5f*w,  0.5f*h, -0.5f*d));
+    vdata0.push_back(Vec(-0.5f*w, -0.5f*h,  0.5f*d));
+    vdata0.push_back(Vec( 0.5f*w, -0.5f*h,  0.5f*d));
+    vdata0.push_back(Vec( 0.5f*w,  0.5f*h,  0.5f*d));
+    vdata0.push_back(Vec(-0.5f*w,  0.5f*h,  0.5f*d));
+  }
+
+  Real width, height, depth;
+};
+
+typedef BodyStateT<FloatPrecision> BodyState;
+typedef BodyAttributesT<FloatPrecision> BodyAttributes;
+typedef BoxT<FloatPrecision> Box;
+
+#endif  /* _RIGIDBODY_HPP_ */
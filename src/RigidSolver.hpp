@@ -19,190 +19,402 @@
 #ifndef _RIGIDSOLVER_HPP_
 #define _RIGIDSOLVER_HPP_
 
-#include <glm/ext/matrix_transform.hpp>
-#include <glm/gtc/quaternion.hpp>
+#include <algorithm>
+#include <cmath>
 #include <iostream>
-#include "Vector3.hpp"
-#include "Matrix3x3.hpp"
-
-// A helper function to compute the cross product of two 3D vectors.
-// We define it here as a free function for clarity.
-inline Vec3f crossProduct(const Vec3f &a, const Vec3f &b)
-{
-  // Cross product: a x b
-  return Vec3f(
-    a[1]*b[2] - a[2]*b[1],
-    a[2]*b[0] - a[0]*b[2],
-    a[0]*b[1] - a[1]*b[0]
-  );
-}
-
-struct BodyAttributes {
-  BodyAttributes()
-    : X(0, 0, 0), R(Mat3f::I()), P(0, 0, 0), L(0, 0, 0),
-      V(0, 0, 0), omega(0, 0, 0), F(0, 0, 0), tau(0, 0, 0),
-      q(1.f, 0.f, 0.f, 0.f) // Initialize quaternion as identity
-  {}
-
-  // This function returns the model matrix for rendering.
-  glm::mat4 worldMat() const {
-    return glm::mat4(
-      R(0,0), R(1,0), R(2,0), 0,
-      R(0,1), R(1,1), R(2,1), 0,
-      R(0,2), R(1,2), R(2,2), 0,
-      X[0],   X[1],   X[2],   1
-    );
-  }
-
-  tReal M;       // Mass
-  Mat3f I0;      // Inertia tensor in body space
-  Mat3f I0inv;   // Inverse of I0
-  Mat3f Iinv;    // Inverse inertia tensor in world space
-
-  Vec3f X;       // Position
-  Mat3f R;       // Rotation matrix (for rendering)
-  Vec3f P;       // Linear momentum
-  Vec3f L;       // Angular momentum
-
-  Vec3f V;       // Linear velocity
-  Vec3f omega;   // Angular velocity
-
-  Vec3f F;       // Force
-  Vec3f tau;     // Torque
-
-  glm::quat q;   // Quaternion to represent orientation
-
-  // Vertices in body space
-  std::vector<Vec3f> vdata0;
+#include <memory>
+#include <vector>
+#include "RigidBody.hpp"
+#include "ForceGenerators.hpp"
+
+// Static, infinitely heavy half-space {x | n.x >= d}
+template<typename Policy>
+struct StaticPlaneT {
+  typename Policy::Vec n;       // Unit normal pointing to the free side
+  typename Policy::PosReal d;   // Offset along the normal
 };
 
-class Box : public BodyAttributes {
+// The solver, its bodies and its force generators share a precision policy
+// (see RigidBody.hpp).
+template<typename Policy>
+class RigidSolverT {
 public:
-  explicit Box(
-    tReal w = 1.0,
-    tReal h = 1.0,
-    tReal d = 1.0,
-    tReal dens = 10.0,
-    const Vec3f v0 = Vec3f(0, 0, 0),
-    const Vec3f omega0 = Vec3f(0, 0, 0))
-    : width(w), height(h), depth(d)
+  typedef typename Policy::Real Real;
+  typedef typename Policy::PosReal PosReal;
+  typedef typename Policy::Vec Vec;
+  typedef typename Policy::Pos Pos;
+  typedef typename Policy::Mat Mat;
+  typedef typename Policy::Quat Quat;
+  typedef BodyAttributesT<Policy> Body;
+  typedef ForceGeneratorT<Policy> Generator;
+  typedef StaticPlaneT<Policy> Plane;
+
+  // Everything needed to restart the simulation from a given step
+  struct State {
+    std::vector<BodyStateT<Policy> > bodies;
+    tIndex step;
+    Real t;
+    tIndex events;
+  };
+
+  explicit RigidSolverT(
+    Body *body0 = nullptr,
+    const Vec g = Vec(0, 0, 0))
+    : _step(0), _sim_t(0), _events(0),
+      _implicitGyro(true), _verbose(true),
+      _restitution(0.5), _friction(0.3), _ccdFraction(0.25)
   {
-    // Initial linear and angular velocity
-    V = v0;
-    omega = omega0;
-
-    // Compute mass
-    M = dens * w * h * d;
-
-    // Compute inertia tensor for a box with center at (0,0,0).
-    // Ixx = (1/12)*M*(h^2 + d^2), etc.
-    const tReal oneTwelfth = static_cast<tReal>(1.0 / 12.0);
-    const tReal Ixx = oneTwelfth * M * (h*h + d*d);
-    const tReal Iyy = oneTwelfth * M * (w*w + d*d);
-    const tReal Izz = oneTwelfth * M * (w*w + h*h);
-
-    // Fill I0 manually
-    I0(0,0) = Ixx;  I0(0,1) = 0.0f; I0(0,2) = 0.0f;
-    I0(1,0) = 0.0f; I0(1,1) = Iyy;  I0(1,2) = 0.0f;
-    I0(2,0) = 0.0f; I0(2,1) = 0.0f; I0(2,2) = Izz;
-
-    // Precompute the inverse of I0
-    I0inv = I0.inverse();
-    // Set the current world-space inverse inertia to I0inv initially
-    Iinv = I0inv;
-
-    // Define 8 vertices in body space
-    vdata0.push_back(Vec3f(-0.5f*w, -0.5f*h, -0.5f*d));
-    vdata0.push_back(Vec3f( 0.5f*w, -0.5f*h, -0.5f*d));
-    vdata0.push_back(Vec3f( 0.5f*w,  0.5f*h, -0.5f*d));
-    vdata0.push_back(Vec3f(-0.5f*w,  0.5f*h, -0.5f*d));
-    vdata0.push_back(Vec3f(-0.5f*w, -0.5f*h,  0.5f*d));
-    vdata0.push_back(Vec3f( 0.5f*w, -0.5f*h,  0.5f*d));
-    vdata0.push_back(Vec3f( 0.5f*w,  0.5f*h,  0.5f*d));
-    vdata0.push_back(Vec3f(-0.5f*w,  0.5f*h,  0.5f*d));
-  }
-
-  tReal width, height, depth;
-};
+    if(g.lengthSquare() > 0)
+      addForceGenerator(std::make_shared<UniformGravityT<Policy> >(g));
+    init(body0);
+  }
 
-class RigidSolver {
-public:
-  explicit RigidSolver(
-    BodyAttributes *body0 = nullptr,
-    const Vec3f g = Vec3f(0, 0, 0))
-    : body(body0), _g(g), _step(0), _sim_t(0)
-  {}
-
-  void init(BodyAttributes *body0) {
-    body = body0;
+  // Restart with body0 as the only body
+  void init(Body *body0) {
+    _bodies.clear();
+    if(body0) _bodies.push_back(body0);
     _step = 0;
     _sim_t = 0;
+    _events = 0;
+  }
+
+  // Bodies are not owned by the solver. Returns the index of the body.
+  tIndex addBody(Body *body) {
+    _bodies.push_back(body);
+    return static_cast<tIndex>(_bodies.size() - 1);
+  }
+  const std::vector<Body *>& bodies() const { return _bodies; }
+  Body* body(const tIndex i) const { return _bodies[i]; }
+
+  // Forces are accumulated by the registered generators, in order
+  // World positions held by the generator are taken in the current frame
+  void addForceGenerator(const std::shared_ptr<Generator> &gen) {
+    gen->setOrigin(_origin, false);
+    _forceGens.push_back(gen);
+  }
+  void clearForceGenerators() { _forceGens.clear(); }
+  const std::vector<std::shared_ptr<Generator> >& forceGenerators() const {
+    return _forceGens;
   }
 
-  void step(const tReal dt) {
-    std::cout << "t=" << _sim_t << " (dt=" << dt << ")" << std::endl;
+  void step(const Real dt) {
+    if(_verbose)
+      std::cout << "t=" << _sim_t << " (dt=" << dt << ")" << std::endl;
 
     // 1) Compute force and torque
-    computeForceAndTorque();
+    computeForceAndTorque(dt);
+
+    for(Body *body : _bodies) {
+      Body &b = *body;
+
+      // 2) Integrate linear momentum
+      b.P += b.F * dt;
+      b.V = b.P / b.M;
+
+      // 3) Integrate angular momentum
+      if(b.diagonalInertia)
+        integrateAngular<true>(b, dt);
+      else
+        integrateAngular<false>(b, dt);
+
+      // 4) Resolve contacts, then integrate position and orientation
+      Real toi = dt;
+      if(isFast(b, dt)) {
+        for(const Plane &pl : _planes)
+          toi = std::min(toi, timeOfImpact(b, pl, dt));
+      }
+      if(toi < dt) {
+        // Move to the time of impact, collide there and use the rest of the
+        // step with the post-impact velocities.
+        integratePositions(b, toi);
+        resolveContacts(b, dt - toi);
+        integratePositions(b, dt - toi);
+      } else {
+        if(!_planes.empty()) resolveContacts(b, dt);
+        integratePositions(b, dt);
+      }
+      b.updateCell();
+    }
+
+    ++_step;
+    _sim_t += dt;
+  }
+
+  // Toggle the implicit treatment of the gyroscopic term (default: on).
+  void setImplicitGyroscopic(const bool enabled) { _implicitGyro = enabled; }
+  bool implicitGyroscopic() const { return _implicitGyro; }
+
+  // Static colliders, e.g., the floor and the walls
+  void addStaticPlane(const Vec &normal, const Pos &point) {
+    Plane pl;
+    pl.n = normal.normalized();
+    pl.d = Pos(pl.n).dotProduct(point);
+    _planes.push_back(pl);
+  }
+  void clearStaticPlanes() { _planes.clear(); }
+  const std::vector<Plane>& staticPlanes() const { return _planes; }
+
+  void setRestitution(const Real e) { _restitution = e; }
+  void setFriction(const Real mu) { _friction = mu; }
+  // Bodies moving more than this fraction of their bounding radius per step
+  // use continuous collision detection.
+  void setCCDFraction(const Real f) { _ccdFraction = f; }
+
+  // Print every step to the standard output (default: on)
+  void setVerbose(const bool verbose) { _verbose = verbose; }
+  bool verbose() const { return _verbose; }
+
+  // Fills s, reusing its storage when called repeatedly
+  void saveState(State &s) const {
+    s.bodies.resize(_bodies.size());
+    for(std::size_t i = 0; i < _bodies.size(); ++i)
+      s.bodies[i] = _bodies[i]->state();
+    s.step = _step;
+    s.t = _sim_t;
+    s.events = _events;
+  }
+  State saveState() const {
+    State s;
+    saveState(s);
+    return s;
+  }
+  void restoreState(const State &s) {
+    for(std::size_t i = 0; i < _bodies.size(); ++i)
+      _bodies[i]->setState(s.bodies[i]);
+    _step = s.step;
+    _sim_t = s.t;
+    _events = s.events;
+  }
+
+  tIndex stepCount() const { return _step; }
+  Real time() const { return _sim_t; }
+  // Number of impulsive events (instant forces, impacts) applied so far
+  tIndex eventCount() const { return _events; }
+
+  // The simulation frame is centered on the origin cell: static planes and
+  // the world positions held by force generators are relative to it. Bodies
+  // are not, each one being relative to its own cell.
+  const GridCell& origin() const { return _origin; }
+  // Move the simulation frame to another cell; planes and force generators
+  // are re-expressed relative to it, bodies are unchanged.
+  void setOrigin(const GridCell &origin) {
+    const Pos delta = cellOffset<PosReal>(_origin, origin);
+    for(Plane &pl : _planes)
+      pl.d -= Pos(pl.n).dotProduct(delta);
+    for(const std::shared_ptr<Generator> &gen : _forceGens)
+      gen->setOrigin(origin);
+    _origin = origin;
+  }
+
+private:
+  template<bool Diagonal>
+  void integrateAngular(Body &b, const Real dt) {
+    if(_implicitGyro) {
+      // Angular velocity is the state: apply the torque impulse, then solve
+      // for the gyroscopic term in body space.
+      b.omega += b.template worldInvInertiaMul<Diagonal>(b.tau * dt);
+      integrateGyroscopicImplicit<Diagonal>(b, dt);
+    } else {
+      b.L += b.tau * dt;
+      b.omega = b.template worldInvInertiaMul<Diagonal>(b.L);
+    }
+  }
 
-    // 2) Integrate linear momentum and position
-    body->P += body->F * dt;
-    body->V = body->P / body->M;
-    body->X += body->V * dt;
+  // Solve the torque-free Euler equation with the implicit midpoint rule,
+  // I*(w - w0) + dt*(m x I*m) = 0 with m = (w + w0)/2, in body space with
+  // two Newton iterations starting at w0. Unlike the explicit update, this
+  // does not inject energy into fast-spinning, elongated bodies, and unlike
+  // implicit Euler it does not drain it either: the midpoint rule keeps
+  // both the kinetic energy and |L|, being quadratic invariants.
+  template<bool Diagonal>
+  void integrateGyroscopicImplicit(Body &b, const Real dt) {
+    const Vec w0 = b.toBody(b.omega);
+    const Vec Iw0 = b.template inertiaMul<Diagonal>(w0);
+    Vec w = w0;
+    for(int it = 0; it < 2; ++it) {
+      const Vec m = (w + w0) * static_cast<Real>(0.5);
+      const Vec Im = b.template inertiaMul<Diagonal>(m);
+      const Vec f = b.template inertiaMul<Diagonal>(w) - Iw0 + m.crossProduct(Im) * dt;
+      const Mat J = b.I0 +
+        (b.template matMulInertia<Diagonal>(m.crossProductMatrix())
+         - Im.crossProductMatrix()) * (dt * static_cast<Real>(0.5));
+      w -= J.solve(f);
+    }
 
-    // 3) Integrate angular momentum and orientation
-    body->L += body->tau * dt;
+    b.omega = b.toWorld(w);
+    b.L = b.toWorld(b.template inertiaMul<Diagonal>(w));
+  }
 
-    // Update inverse inertia in world space
-    body->Iinv = body->R * body->I0inv * body->R.transpose();
-    body->omega = body->Iinv * body->L;
+  void integratePositions(Body &b, const Real dt) {
+    b.X += Pos(b.V) * static_cast<PosReal>(dt);
 
     // Update quaternion by angular velocity
-    glm::quat wq(0.0f, body->omega[0], body->omega[1], body->omega[2]);
-    glm::quat dq = 0.5f * wq * body->q;
-    body->q += dq * static_cast<float>(dt);
-    body->q = glm::normalize(body->q);
-
-    // Convert quaternion back to a rotation matrix
-    glm::mat3 rot = glm::mat3_cast(body->q);
-    for(int i = 0; i < 3; i++){
-      for(int j = 0; j < 3; j++){
-        body->R(i, j) = rot[i][j];
-      }
+    Quat wq(0, b.omega[0], b.omega[1], b.omega[2]);
+    Quat dq = static_cast<Real>(0.5) * wq * b.q;
+    b.q += dq * dt;
+    b.q = glm::normalize(b.q);
+  }
+
+  bool isFast(const Body &b, const Real dt) const {
+    if(_planes.empty()) return false;
+    const Real r = b.boundingRadius();
+    const Real motion = (b.V.length() + b.omega.length()*r)*dt;
+    return motion > _ccdFraction*r;
+  }
+
+  // Signed distance from the plane to the closest vertex, for the body
+  // moved by its current velocities during t.
+  Real planeDistance(
+    const Body &b, const Plane &pl, const Real t) const {
+    const Real w = b.omega.length();
+    Quat q = b.q;
+    if(w > 0) {
+      const Vec a = b.omega / w;
+      q = glm::angleAxis(w*t, glm::vec<3, Real, glm::defaultp>(a[0], a[1], a[2]))*q;
     }
+    const Mat R = quatToMat3(q);
+    Real dist = centerDistance(b, pl) + pl.n.dotProduct(b.V*t);
+    const Real d0 = dist;
+    for(const Vec &v : b.vdata0)
+      dist = std::min(dist, d0 + pl.n.dotProduct(R*v));
+    return dist;
+  }
 
-    // Clear force and torque
-    body->F = Vec3f(0, 0, 0);
-    body->tau = Vec3f(0, 0, 0);
+  // Signed distance from the plane to the center of mass. This is the only
+  // place where positions meet the plane; everything else is relative to X.
+  Real centerDistance(const Body &b, const Plane &pl) const {
+    return static_cast<Real>(Pos(pl.n).dotProduct(b.positionFrom(_origin)) - pl.d);
+  }
 
-    ++_step;
-    _sim_t += dt;
+  // Conservative advancement: no vertex approaches the plane faster than
+  // the bound below, so advancing by distance/bound never skips the impact.
+  // Returns dt when there is no impact within the step.
+  Real timeOfImpact(
+    const Body &b, const Plane &pl, const Real dt) const {
+    const Real r = b.boundingRadius();
+    const Real bound = -pl.n.dotProduct(b.V) + b.omega.length()*r;
+    if(bound <= 0) return dt;
+
+    const Real tol = static_cast<Real>(1e-3)*r;
+    Real t = 0;
+    for(int it = 0; it < 32; ++it) {
+      const Real dist = planeDistance(b, pl, t);
+      if(dist < tol) return t;
+      t += dist/bound;
+      if(t >= dt) return dt;
+    }
+    return t;
+  }
+
+  // Apply an impulse J at r (relative to the center of mass, world space);
+  // R is the current rotation matrix of the body.
+  void applyImpulse(
+    Body &b, const Mat &R, const Vec &r, const Vec &J) {
+    const Vec dL = r.crossProduct(J);
+    b.P += J;
+    b.V = b.P / b.M;
+    b.L += dL;
+    b.omega += b.worldInvInertiaMul(R, dL);
   }
 
-  BodyAttributes *body;
+  // Inverse effective mass of the body at r along the unit direction u
+  Real invEffectiveMass(
+    const Body &b, const Mat &R, const Vec &r, const Vec &u) const {
+    const Vec ru = r.crossProduct(u);
+    return 1/b.M + ru.dotProduct(b.worldInvInertiaMul(R, ru));
+  }
 
-private:
-  void computeForceAndTorque() {
-    // Reset force and torque, then add gravity
-    body->F = body->M * _g;
-    body->tau = Vec3f(0, 0, 0);
-
-    // Apply a one-time instant force at step 1
-    if(_step == 1) {
-      Vec3f instF(0.15f, 0.25f, 0.03f);
-      body->F += instF;
-
-      // Compute torque: tau = r x F
-      // r is the world-space position of vertex 0 relative to the center.
-      Vec3f r = body->R * body->vdata0[0];
-      Vec3f t = crossProduct(r, instF);
-      body->tau += t;
+  // Vertex-plane contacts with sequential impulses, one per plane applied at
+  // the centroid of the contacting vertices so that resting faces do not
+  // spin. Contacts are speculative: a vertex that is still apart only loses
+  // the velocity that would make it cross the plane before the end of the
+  // horizon h, so collisions are caught one step early instead of after
+  // penetration.
+  void resolveContacts(Body &b, const Real h) {
+    const Real slop = static_cast<Real>(1e-3)*b.boundingRadius();
+    const Real impactSpeed = 0.1;   // Below this, a contact is resting
+    const Real beta = 0.2;          // Fraction of penetration fixed per step
+    const Real hInv = 1/std::max(h, static_cast<Real>(1e-6));
+    const Mat R = b.rotation();  // Orientation is fixed during contacts
+    bool impact = false;
+
+    for(int it = 0; it < 4; ++it) {
+      for(const Plane &pl : _planes) {
+        // Gather the vertices touching or about to touch the plane
+        const Real d0 = centerDistance(b, pl);
+        Vec r(0);
+        Real gap = 0;
+        tIndex n = 0;
+        for(const Vec &v0 : b.vdata0) {
+          const Vec ri = R * v0;
+          const Real gi = d0 + pl.n.dotProduct(ri);
+          const Real vn = pl.n.dotProduct(b.V + b.omega.crossProduct(ri));
+          if(gi <= slop || gi + vn*h < 0) {
+            gap = n ? std::min(gap, gi) : gi;
+            r += ri;
+            ++n;
+          }
+        }
+        if(!n) continue;
+        r /= static_cast<Real>(n);
+
+        const Vec v = b.V + b.omega.crossProduct(r);
+        const Real vn = pl.n.dotProduct(v);
+
+        Real target;
+        if(gap > slop) {
+          target = -gap*hInv;
+        } else {
+          const bool bounce = (vn < -impactSpeed);
+          impact = impact || bounce;
+          target = std::max(bounce ? -_restitution*vn : 0,
+                            -beta*std::min(gap, static_cast<Real>(0))*hInv);
+        }
+        if(vn >= target) continue;
+
+        // Normal impulse
+        const Real jn = (target - vn)/invEffectiveMass(b, R, r, pl.n);
+        applyImpulse(b, R, r, pl.n*jn);
+
+        // Coulomb friction, bounded by the normal impulse
+        const Vec vt = v - pl.n*vn;
+        const Real vtLen = vt.length();
+        if(vtLen > 0 && _friction > 0) {
+          const Vec t = vt / vtLen;
+          const Real jt = std::min(vtLen/invEffectiveMass(b, R, r, t), _friction*jn);
+          applyImpulse(b, R, r, t*(-jt));
+        }
+      }
+    }
+
+    if(impact) ++_events;
+  }
+
+  void computeForceAndTorque(const Real dt) {
+    for(Body *body : _bodies) {
+      body->F = Vec(0, 0, 0);
+      body->tau = Vec(0, 0, 0);
     }
+    for(const std::shared_ptr<Generator> &gen : _forceGens)
+      _events += gen->apply(_bodies, _sim_t, dt);
   }
 
-  Vec3f _g;      // Gravity
   tIndex _step;  // Simulation step count
-  tReal _sim_t;  // Simulation time
+  Real _sim_t;  // Simulation time
+  tIndex _events; // Impulsive event count
+  bool _implicitGyro; // Implicit gyroscopic integration
+  bool _verbose;
+
+  GridCell _origin;   // Cell the simulation frame is centered on
+  std::vector<Body *> _bodies;
+  std::vector<std::shared_ptr<Generator> > _forceGens;
+  std::vector<Plane> _planes;
+  Real _restitution;  // Coefficient of restitution for impacts
+  Real _friction;     // Coulomb friction coefficient
+  Real _ccdFraction;  // Motion per step relative to size triggering CCD
 };
 
+typedef StaticPlaneT<FloatPrecision> StaticPlane;
+typedef RigidSolverT<FloatPrecision> RigidSolver;
+
 #endif  /* _RIGIDSOLVER_HPP_ */
@@ -54,6 +54,44 @@ void ShaderProgram::loadShader(GLenum type, const std::string &shaderFilename)
   glDeleteShader(shader);
 }
 
+// Introspect the linked program for its active uniforms. Arrays are
+// reported by their first element, "a[0]", and also found as "a".
+void ShaderProgram::link()
+{
+  glLinkProgram(_id);
+  GLint linked;
+  glGetProgramiv(_id, GL_LINK_STATUS, &linked);
+  if(!linked) {
+    GLsizei len;
+    glGetProgramiv(_id, GL_INFO_LOG_LENGTH, &len);
+    GLchar *log = new GLchar[len+1];
+    glGetProgramInfoLog(_id, len, &len, log);
+    std::cerr << "Link error in program " << _id << " : " << std::endl << log << std::endl;
+    delete [] log;
+  }
+
+  _uniforms.clear();
+  _handles.clear();
+  GLint count = 0, maxLength = 0;
+  glGetProgramiv(_id, GL_ACTIVE_UNIFORMS, &count);
+  glGetProgramiv(_id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+  std::vector<GLchar> name(maxLength + 1);
+  for(GLint i = 0; i < count; ++i) {
+    GLsizei length;
+    GLint size;
+    GLenum type;
+    glGetActiveUniform(_id, i, maxLength + 1, &length, &size, &type, name.data());
+    const GLint location = glGetUniformLocation(_id, name.data());
+    if(location < 0) continue;  // In a uniform block
+    const Uniform u = { location, false, {0} };
+    const int h = static_cast<int>(_uniforms.size());
+    _uniforms.push_back(u);
+    std::string n(name.data(), length);
+    _handles[n] = h;
+    if(n.size() > 3 && n.compare(n.size() - 3, 3, "[0]") == 0)
+      _handles[n.substr(0, n.size() - 3)] = h;
+  }
+}
 
 std::shared_ptr<ShaderProgram> ShaderProgram::genBasicShaderProgram(
   const std::string &vertexShaderFilename,
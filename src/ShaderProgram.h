@@ -4,6 +4,9 @@
 #include <glad/gl.h>
 #include <string>
 #include <memory>
+#include <vector>
+#include <unordered_map>
+#include <cstring>
 #include <glm/glm.hpp>
 #include <glm/ext.hpp>
 
@@ -23,8 +26,9 @@ public:
   // Loads and compile a shader from a text file, before attaching it to a program
   void loadShader(GLenum type, const std::string &shaderFilename);
 
-  // The main GPU program is ready to be handle streams of polygons
-  void link() { glLinkProgram(_id); }
+  // The main GPU program is ready to be handle streams of polygons. Linking
+  // also caches the locations of all the active uniforms.
+  void link();
 
   // Activate the program
   void use() { glUseProgram(_id); }
@@ -32,51 +36,99 @@ public:
   // Desactivate the current program
   static void stop() { glUseProgram(0); }
 
-  GLuint getLocation(const std::string &name) const
+  GLint getLocation(const std::string &name) const
   {
-    return glGetUniformLocation(_id, name.c_str());
+    const int h = handle(name);
+    return h < 0 ? -1 : _uniforms[h].location;
   }
 
-  void set(const std::string &name, int value)
+  // Attach the uniform block of that name, if the program uses it, to a
+  // binding point shared with the other programs
+  void bindUniformBlock(const std::string &name, GLuint binding)
   {
-    glUniform1i(getLocation(name.c_str()), value);
+    const GLuint index = glGetUniformBlockIndex(_id, name.c_str());
+    if(index != GL_INVALID_INDEX) glUniformBlockBinding(_id, index, binding);
   }
 
-  void set(const std::string &name, float value)
+  // Handle of an active uniform, or -1 if the program has none by that name
+  // (the setters then do nothing, like OpenGL with location -1). Look handles
+  // up once; setting through them involves no string, and a value equal to
+  // the one last set is not uploaded again. The program must be in use.
+  int handle(const std::string &name) const
   {
-    glUniform1f(getLocation(name.c_str()), value);
+    auto it = _handles.find(name);
+    return it == _handles.end() ? -1 : it->second;
   }
 
-  void set(const std::string &name, const glm::vec2 &value)
+  void set(int h, int value)
   {
-    glUniform2fv(getLocation(name.c_str()), 1, glm::value_ptr(value));
+    if(changed(h, &value, sizeof(value))) glUniform1i(_uniforms[h].location, value);
   }
 
-  void set(const std::string &name, const glm::vec3 &value)
+  void set(int h, float value)
   {
-    glUniform3fv(getLocation(name.c_str()), 1, glm::value_ptr(value));
+    if(changed(h, &value, sizeof(value))) glUniform1f(_uniforms[h].location, value);
   }
 
-  void set(const std::string &name, const glm::vec4 &value)
+  void set(int h, const glm::vec2 &value)
   {
-    glUniform4fv(getLocation(name.c_str()), 1, glm::value_ptr(value));
+    if(changed(h, &value, sizeof(value)))
+      glUniform2fv(_uniforms[h].location, 1, glm::value_ptr(value));
   }
 
-  void set(const std::string &name, const glm::mat4 &value)
+  void set(int h, const glm::vec3 &value)
   {
-    glUniformMatrix4fv(getLocation(name.c_str()), 1, GL_FALSE, glm::value_ptr(value));
+    if(changed(h, &value, sizeof(value)))
+      glUniform3fv(_uniforms[h].location, 1, glm::value_ptr(value));
   }
 
-  void set(const std::string &name, const glm::mat3 &value)
+  void set(int h, const glm::vec4 &value)
   {
-    glUniformMatrix3fv(getLocation(name.c_str()), 1, GL_FALSE, glm::value_ptr(value));
+    if(changed(h, &value, sizeof(value)))
+      glUniform4fv(_uniforms[h].location, 1, glm::value_ptr(value));
   }
 
+  void set(int h, const glm::mat4 &value)
+  {
+    if(changed(h, &value, sizeof(value)))
+      glUniformMatrix4fv(_uniforms[h].location, 1, GL_FALSE, glm::value_ptr(value));
+  }
+
+  void set(int h, const glm::mat3 &value)
+  {
+    if(changed(h, &value, sizeof(value)))
+      glUniformMatrix3fv(_uniforms[h].location, 1, GL_FALSE, glm::value_ptr(value));
+  }
+
+  // Same by name, through the cache
+  template<typename T>
+  void set(const std::string &name, const T &value) { set(handle(name), value); }
+
 private:
   // Loads the content of an ASCII file in a standard C++ string
   std::string file2String(const std::string &filename);
 
+  // Whether value differs from the last one set through handle h, which
+  // then records it
+  bool changed(int h, const void *value, size_t size)
+  {
+    if(h < 0) return false;
+    Uniform &u = _uniforms[h];
+    if(u.set && !std::memcmp(u.value, value, size)) return false;
+    std::memcpy(u.value, value, size);
+    u.set = true;
+    return true;
+  }
+
+  struct Uniform {
+    GLint location;
+    bool set;                   // Whether value holds the current value
+    unsigned char value[sizeof(glm::mat4)];
+  };
+
   GLuint _id = 0;
+  std::vector<Uniform> _uniforms;
+  std::unordered_map<std::string, int> _handles;
 };
 
 #endif  // SHADER_PROGRAM_H
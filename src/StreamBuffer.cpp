@@ -0,0 +1,97 @@
+#include "StreamBuffer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+StreamBuffer::~StreamBuffer()
+{
+  clear();
+}
+
+// Regions are 256-byte aligned, a multiple of any offset alignment a binding
+// may require, and grow by doubling.
+void StreamBuffer::allocate(size_t regionSize)
+{
+  regionSize = (regionSize + 255) & ~static_cast<size_t>(255);
+  _regionSize = std::max(regionSize, 2*_regionSize);
+  if(!_buffer) glGenBuffers(1, &_buffer);
+  glBindBuffer(_target, _buffer);
+  glBufferData(_target, _regionSize*_fences.size(), nullptr, GL_STREAM_DRAW);
+  deleteFences();
+}
+
+void StreamBuffer::deleteFences()
+{
+  for(GLsync &f : _fences) {
+    if(f) glDeleteSync(f);
+    f = nullptr;
+  }
+}
+
+void *StreamBuffer::map(size_t size, GLintptr &offset)
+{
+  if(size > _regionSize) allocate(size);
+  glBindBuffer(_target, _buffer);
+
+  _current = (_current + 1) % _fences.size();
+  GLsync &f = _fences[_current];
+  if(f) {
+    // Poll without waiting
+    const GLenum status = glClientWaitSync(f, 0, 0);
+    if(status == GL_TIMEOUT_EXPIRED || status == GL_WAIT_FAILED) {
+      glBufferData(_target, _regionSize*_fences.size(), nullptr, GL_STREAM_DRAW);
+      deleteFences();
+      ++_orphans;
+    } else {
+      glDeleteSync(f);
+      f = nullptr;
+    }
+  }
+
+  offset = static_cast<GLintptr>(_current*_regionSize);
+  return glMapBufferRange(
+    _target, offset, static_cast<GLsizeiptr>(size),
+    GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+}
+
+bool StreamBuffer::unmap()
+{
+  glBindBuffer(_target, _buffer);
+  return glUnmapBuffer(_target) == GL_TRUE;
+}
+
+GLintptr StreamBuffer::write(const void *data, size_t size)
+{
+  GLintptr offset = 0;
+  void *dst = map(size, offset);
+  if(!dst) {
+    std::cerr << "[Stream Buffer][write] Cannot map " << size << " bytes at offset "
+              << offset << " (GL error " << glGetError() << ")" << std::endl;
+    return -1;
+  }
+  std::memcpy(dst, data, size);
+  if(!unmap()) {
+    std::cerr << "[Stream Buffer][write] Buffer content lost while mapped" << std::endl;
+    return -1;
+  }
+  return offset;
+}
+
+void StreamBuffer::fence()
+{
+  GLsync &f = _fences[_current];
+  if(f) glDeleteSync(f);
+  f = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void StreamBuffer::clear()
+{
+  deleteFences();
+  if(_buffer) {
+    glDeleteBuffers(1, &_buffer);
+    _buffer = 0;
+  }
+  _regionSize = 0;
+  _current = 0;
+}
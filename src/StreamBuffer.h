@@ -0,0 +1,53 @@
+#ifndef STREAM_BUFFER_H
+#define STREAM_BUFFER_H
+
+#include <glad/gl.h>
+#include <vector>
+#include <cstddef>
+
+// GPU buffer rewritten every frame, e.g., per-instance transforms. The
+// buffer is split into a ring of regions, each written through an
+// unsynchronized mapping and guarded by a fence placed after the draw calls
+// reading it. The CPU never waits for the GPU: if the next region is still
+// in use, the whole buffer is orphaned, i.e., the driver hands over fresh
+// storage and releases the old one once the GPU is done with it.
+class StreamBuffer {
+public:
+  explicit StreamBuffer(GLenum target = GL_ARRAY_BUFFER, unsigned int regionCount = 3)
+    : _target(target), _fences(regionCount, nullptr) {}
+  virtual ~StreamBuffer();
+  StreamBuffer(const StreamBuffer &) = delete;
+  StreamBuffer& operator=(const StreamBuffer &) = delete;
+
+  GLuint id() const { return _buffer; }
+
+  // Map the next region for writing size bytes; offset receives its offset
+  // in the buffer, to bind it from. Call unmap() when done, unless the
+  // mapping failed and null was returned.
+  void *map(size_t size, GLintptr &offset);
+  // False if the content of the buffer was lost while mapped
+  bool unmap();
+  // Copy size bytes into the next region. Returns its offset, or -1 if the
+  // region could not be written, in which case nothing must be drawn from it.
+  GLintptr write(const void *data, size_t size);
+  // Mark the end of the commands reading the region last written
+  void fence();
+
+  // Times the CPU caught up with the GPU and the buffer was orphaned
+  size_t orphanCount() const { return _orphans; }
+
+  void clear();
+
+private:
+  void allocate(size_t regionSize);
+  void deleteFences();
+
+  GLenum _target;
+  GLuint _buffer = 0;
+  size_t _regionSize = 0;
+  std::vector<GLsync> _fences;  // One per region, null when not in use
+  unsigned int _current = 0;    // Region last written
+  size_t _orphans = 0;
+};
+
+#endif  // STREAM_BUFFER_H
@@ -25,9 +25,86 @@
 #include "Matrix3x3.hpp"
 
 template<typename T> class Matrix3x3;
+template<typename T> class Vector3;
+
+// Expression templates: arithmetic on vectors builds a lightweight
+// expression object, and the whole expression is evaluated component by
+// component when it is assigned to a Vector3, e.g., P += F*dt or
+// X = X0 + V*t - c, without temporary vectors. Expressions convert
+// implicitly to Vector3, so functions taking a const Vector3 & accept
+// them. Do not keep an expression in an auto variable: it references its
+// operands.
+template<typename E, typename T>
+class VecExpr {
+public:
+  typedef T ValueT;
+
+  const E& self() const { return static_cast<const E &>(*this); }
+
+  template<typename E2>
+  T dotProduct(const VecExpr<E2, T> &r) const {
+    const E &a = self();
+    const E2 &b = r.self();
+    return a.at(0)*b.at(0) + a.at(1)*b.at(1) + a.at(2)*b.at(2);
+  }
+  Vector3<T> crossProduct(const Vector3<T> &r) const {
+    const Vector3<T> a(self());
+    return Vector3<T>(a.y*r.z - a.z*r.y, a.z*r.x - a.x*r.z, a.x*r.y - a.y*r.x);
+  }
+
+  T lengthSquare() const {
+    const Vector3<T> a(self());
+    return (a.x*a.x + a.y*a.y + a.z*a.z);
+  }
+  T length() const { return std::sqrt(lengthSquare()); }
+  T distanceTo(const Vector3<T> &t) const { return (self()-t).length(); }
+  T distanceSquareTo(const Vector3<T> &t) const { return (self()-t).lengthSquare(); }
+  Vector3<T> normalized() const { return Vector3<T>(self()).normalize(); }
+};
+
+// Operands are held by reference when they are vectors and by value when
+// they are sub-expressions, which are small and usually temporaries.
+template<typename E> struct VecOperand { typedef const E type; };
+template<typename T> struct VecOperand<Vector3<T> > { typedef const Vector3<T> &type; };
+
+struct VecAdd { template<typename T> static T apply(const T a, const T b) { return a + b; } };
+struct VecSub { template<typename T> static T apply(const T a, const T b) { return a - b; } };
+struct VecMul { template<typename T> static T apply(const T a, const T b) { return a * b; } };
+struct VecDiv { template<typename T> static T apply(const T a, const T b) { return a / b; } };
+
+// Component-wise operation between two vector expressions
+template<typename Op, typename L, typename R, typename T>
+class VecBinaryExpr : public VecExpr<VecBinaryExpr<Op, L, R, T>, T> {
+public:
+  VecBinaryExpr(const L &l, const R &r) : _l(l), _r(r) {}
+  T at(const tIndex i) const { return Op::apply(_l.at(i), _r.at(i)); }
+private:
+  typename VecOperand<L>::type _l;
+  typename VecOperand<R>::type _r;
+};
+
+// Operation between a vector expression and a scalar
+template<typename Op, typename L, typename T>
+class VecScalarExpr : public VecExpr<VecScalarExpr<Op, L, T>, T> {
+public:
+  VecScalarExpr(const L &l, const T s) : _l(l), _s(s) {}
+  T at(const tIndex i) const { return Op::apply(_l.at(i), _s); }
+private:
+  typename VecOperand<L>::type _l;
+  const T _s;
+};
+
+template<typename L, typename T>
+class VecNegExpr : public VecExpr<VecNegExpr<L, T>, T> {
+public:
+  explicit VecNegExpr(const L &l) : _l(l) {}
+  T at(const tIndex i) const { return -_l.at(i); }
+private:
+  typename VecOperand<L>::type _l;
+};
 
 template<typename T>
-class Vector3 {
+class Vector3 : public VecExpr<Vector3<T>, T> {
 public:
   enum { D = 3 };
 
@@ -41,12 +118,35 @@ public:
 
   explicit Vector3(const T &value=0) : x(value), y(value), z(value) {}
   Vector3(const T &a, const T &b, const T &c=0): x(a), y(b), z(c) {}
+  // evaluation of an expression
+  template<typename E>
+  Vector3(const VecExpr<E, T> &e)
+    : x(e.self().at(0)), y(e.self().at(1)), z(e.self().at(2)) {}
 
-  // assignment operators
-  Vector3& operator+=(const Vector3 &r) { x+=r.x; y+=r.y; z+=r.z; return *this; }
-  Vector3& operator-=(const Vector3 &r) { x-=r.x; y-=r.y; z-=r.z; return *this; }
-  Vector3& operator*=(const Vector3 &r) { x*=r.x; y*=r.y; z*=r.z; return *this; }
-  Vector3& operator/=(const Vector3 &r) { x/=r.x; y/=r.y; z/=r.z; return *this; }
+  T at(const tIndex i) const { return v[i]; }
+
+  // assignment operators; component-wise, so the right-hand side may
+  // refer to this vector
+  template<typename E>
+  Vector3& operator=(const VecExpr<E, T> &r) {
+    const E &e = r.self(); x=e.at(0); y=e.at(1); z=e.at(2); return *this;
+  }
+  template<typename E>
+  Vector3& operator+=(const VecExpr<E, T> &r) {
+    const E &e = r.self(); x+=e.at(0); y+=e.at(1); z+=e.at(2); return *this;
+  }
+  template<typename E>
+  Vector3& operator-=(const VecExpr<E, T> &r) {
+    const E &e = r.self(); x-=e.at(0); y-=e.at(1); z-=e.at(2); return *this;
+  }
+  template<typename E>
+  Vector3& operator*=(const VecExpr<E, T> &r) {
+    const E &e = r.self(); x*=e.at(0); y*=e.at(1); z*=e.at(2); return *this;
+  }
+  template<typename E>
+  Vector3& operator/=(const VecExpr<E, T> &r) {
+    const E &e = r.self(); x/=e.at(0); y/=e.at(1); z/=e.at(2); return *this;
+  }
 
   Vector3& operator+=(const T *r) { x+=r[0]; y+=r[1]; z+=r[2]; return *this; }
   Vector3& operator-=(const T *r) { x-=r[0]; y-=r[1]; z-=r[2]; return *this; }
@@ -60,26 +160,15 @@ public:
     const T d=static_cast<T>(1)/s; return operator*=(d);
   }
 
-  // unary operators
+  // unary and binary operators with vectors and scalars are expression
+  // templates, defined below the class
   Vector3 operator+() const { return *this; }
-  Vector3 operator-() const { return Vector3(-x, -y, -z); }
-
-  // binary operators
-  Vector3 operator+(const Vector3 &r) const { return Vector3(*this)+=r; }
-  Vector3 operator-(const Vector3 &r) const { return Vector3(*this)-=r; }
-  Vector3 operator*(const Vector3 &r) const { return Vector3(*this)*=r; }
-  Vector3 operator/(const Vector3 &r) const { return Vector3(*this)/=r; }
 
   Vector3 operator+(const T *r) const { return Vector3(*this)+=r; }
   Vector3 operator-(const T *r) const { return Vector3(*this)-=r; }
   Vector3 operator*(const T *r) const { return Vector3(*this)*=r; }
   Vector3 operator/(const T *r) const { return Vector3(*this)/=r; }
 
-  Vector3 operator+(const T s) const { return Vector3(*this)+=s; }
-  Vector3 operator-(const T s) const { return Vector3(*this)-=s; }
-  Vector3 operator*(const T s) const { return Vector3(*this)*=s; }
-  Vector3 operator/(const T s) const { return Vector3(*this)/=s; }
-
   // comparison operators
   bool operator==(const Vector3 &r) const {
     return ((x==r.x) && (y==r.y) && (z==r.z));
@@ -110,6 +199,10 @@ public:
   Vector3 normalized() const { return Vector3(*this).normalize(); }
 
   T dotProduct(const Vector3 &r) const { return x*r.x + y*r.y + z*r.z; }
+  template<typename E>
+  T dotProduct(const VecExpr<E, T> &r) const {
+    const E &e = r.self(); return x*e.at(0) + y*e.at(1) + z*e.at(2);
+  }
   Vector3 crossProduct(const Vector3 &r) const {
     return Vector3(y*r.z - z*r.y, z*r.x - x*r.z, x*r.y - y*r.x);
   }
@@ -134,8 +227,58 @@ public:
   }
 };
 
-typedef Vector3<tReal> Vec3f;
+template<typename E1, typename E2, typename T>
+inline VecBinaryExpr<VecAdd, E1, E2, T>
+operator+(const VecExpr<E1, T> &l, const VecExpr<E2, T> &r) {
+  return VecBinaryExpr<VecAdd, E1, E2, T>(l.self(), r.self());
+}
+template<typename E1, typename E2, typename T>
+inline VecBinaryExpr<VecSub, E1, E2, T>
+operator-(const VecExpr<E1, T> &l, const VecExpr<E2, T> &r) {
+  return VecBinaryExpr<VecSub, E1, E2, T>(l.self(), r.self());
+}
+template<typename E1, typename E2, typename T>
+inline VecBinaryExpr<VecMul, E1, E2, T>
+operator*(const VecExpr<E1, T> &l, const VecExpr<E2, T> &r) {
+  return VecBinaryExpr<VecMul, E1, E2, T>(l.self(), r.self());
+}
+template<typename E1, typename E2, typename T>
+inline VecBinaryExpr<VecDiv, E1, E2, T>
+operator/(const VecExpr<E1, T> &l, const VecExpr<E2, T> &r) {
+  return VecBinaryExpr<VecDiv, E1, E2, T>(l.self(), r.self());
+}
 
-inline const Vec3f operator*(const tReal s, const Vec3f &r) { return r*s; }
+// The scalar type is not deduced, so that, e.g., v*2 converts 2 to T
+template<typename E, typename T>
+inline VecScalarExpr<VecAdd, E, T>
+operator+(const VecExpr<E, T> &l, const typename VecExpr<E, T>::ValueT s) {
+  return VecScalarExpr<VecAdd, E, T>(l.self(), s);
+}
+template<typename E, typename T>
+inline VecScalarExpr<VecSub, E, T>
+operator-(const VecExpr<E, T> &l, const typename VecExpr<E, T>::ValueT s) {
+  return VecScalarExpr<VecSub, E, T>(l.self(), s);
+}
+template<typename E, typename T>
+inline VecScalarExpr<VecMul, E, T>
+operator*(const VecExpr<E, T> &l, const typename VecExpr<E, T>::ValueT s) {
+  return VecScalarExpr<VecMul, E, T>(l.self(), s);
+}
+template<typename E, typename T>
+inline VecScalarExpr<VecMul, E, T>
+operator*(const typename VecExpr<E, T>::ValueT s, const VecExpr<E, T> &r) {
+  return VecScalarExpr<VecMul, E, T>(r.self(), s);
+}
+template<typename E, typename T>
+inline VecScalarExpr<VecMul, E, T>
+operator/(const VecExpr<E, T> &l, const typename VecExpr<E, T>::ValueT s) {
+  return VecScalarExpr<VecMul, E, T>(l.self(), static_cast<T>(1)/s);
+}
+template<typename E, typename T>
+inline VecNegExpr<E, T> operator-(const VecExpr<E, T> &l) {
+  return VecNegExpr<E, T>(l.self());
+}
+
+typedef Vector3<tReal> Vec3f;
 
 #endif  /* _VECTOR3_HPP_ */
@@ -1,11 +1,13 @@
 #version 330 core            // minimal GL version support expected from the GPU
 
-struct LightSource {
-  vec3 position;
-  vec3 color;
-  float intensity;
+// Per-frame data shared by all programs, std140 layout
+layout(std140) uniform FrameData {
+  mat4 viewMat;
+  mat4 projMat;
+  vec4 camPos;                  // w unused
+  vec4 lightPosition;           // w unused
+  vec4 lightColor;              // rgb: color, a: intensity
 };
-uniform LightSource lightSrc;
 
 struct Material {
   vec3 albedo;
@@ -17,8 +19,6 @@ struct Material {
 };
 uniform Material material;
 
-uniform vec3 camPos;
-
 in vec3 fPositionModel;
 in vec3 fPosition;
 in vec3 fNormal;
@@ -35,8 +35,8 @@ void main() {
     normalize(fNormal);
 
   vec3 radiance = vec3(0, 0, 0);
-  vec3 wi = normalize(lightSrc.position - fPosition); // unit vector pointing to the light source
-  vec3 Li = lightSrc.color*lightSrc.intensity;
+  vec3 wi = normalize(lightPosition.xyz - fPosition); // unit vector pointing to the light source
+  vec3 Li = lightColor.rgb*lightColor.a;
   vec3 albedo = material.albedoTexLoaded==1 ? texture(material.albedoTex, fTexCoord).rgb : material.albedo;
 
   radiance += Li*albedo*max(dot(n, wi), 0);
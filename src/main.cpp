@@ -47,8 +47,12 @@
 #include "ShaderProgram.h"
 #include "Camera.h"
 #include "Mesh.h"
+#include "InstanceBatch.h"
+#include "StreamBuffer.h"
+#include "Checks.h"
 
 #include "RigidSolver.hpp"
+#include "AdaptiveStepper.hpp"
 
 // window parameters
 GLFWwindow *g_window = nullptr;
@@ -127,19 +131,49 @@ struct Light {
   float intensity;
 };
 
+// Uniform block FrameData of the shaders, in std140 layout: vec3 are padded
+// to vec4. Written once per frame and bound for all the programs.
+struct FrameData {
+  glm::mat4 viewMat;
+  glm::mat4 projMat;
+  glm::vec4 camPos;
+  glm::vec4 lightPosition;
+  glm::vec4 lightColor;         // intensity in the 4th component
+};
+static_assert(sizeof(FrameData) == 176, "FrameData must match the std140 layout");
+const GLuint FRAME_DATA_BINDING = 0;
+
+// Handles of the uniforms of a program using fragmentShader.glsl, looked up
+// once after linking
+struct ShadingUniforms {
+  int albedo, albedoTex, albedoTexLoaded, normalTex, normalTexLoaded;
+  int modelMat, normMat;
+
+  void locate(const ShaderProgram &p)
+  {
+    albedo = p.handle("material.albedo");
+    albedoTex = p.handle("material.albedoTex");
+    albedoTexLoaded = p.handle("material.albedoTexLoaded");
+    normalTex = p.handle("material.normalTex");
+    normalTexLoaded = p.handle("material.normalTexLoaded");
+    modelMat = p.handle("modelMat");
+    normMat = p.handle("normMat");
+  }
+};
 
 struct Scene {
   Light light;
 
   RigidSolver solver = RigidSolver(nullptr, Vec3f(0, -0.98, 0));
+  AdaptiveStepper stepper = AdaptiveStepper(nullptr);
   std::shared_ptr<BodyAttributes> rigidAtt = nullptr;
 
   // meshes
   std::shared_ptr<Mesh> rigid = nullptr;
   std::shared_ptr<Mesh> plane = nullptr;
+  std::shared_ptr<InstanceBatch> rigids = nullptr; // all bodies sharing the rigid mesh
 
   // transformation matrices
-  glm::mat4 rigidMat = glm::mat4(1.0);
   glm::mat4 planeMat = glm::mat4(1.0);
   glm::mat4 floorMat = glm::mat4(1.0);
 
@@ -148,6 +182,9 @@ struct Scene {
 
   // shaders to render the meshes
   std::shared_ptr<ShaderProgram> mainShader;
+  std::shared_ptr<ShaderProgram> instancedShader;
+  ShadingUniforms mainUniforms, instancedUniforms;
+  std::shared_ptr<StreamBuffer> frameData;
 
   // useful for debug
   bool saveScreenShot = false;
@@ -157,7 +194,7 @@ struct Scene {
   {
     *rigidAtt = Box(.1f, .1f, .1f);
     solver.init(rigidAtt.get());
-    rigidMat = glm::mat4(1.0);
+    stepper.init(&solver);
   }
 
   void render()
@@ -169,45 +206,50 @@ struct Scene {
     //glDisable(GL_CULL_FACE);    // or
     glCullFace(GL_BACK);
 
+    // camera and light, for all the programs
+    FrameData frame;
+    frame.viewMat = g_cam->computeViewMatrix();
+    frame.projMat = g_cam->computeProjectionMatrix();
+    frame.camPos = glm::vec4(g_cam->getPosition(), 1.0);
+    frame.lightPosition = glm::vec4(light.position, 1.0);
+    frame.lightColor = glm::vec4(light.color, light.intensity);
+    const GLintptr frameOffset = frameData->write(&frame, sizeof(frame));
+    if(frameOffset >= 0)   // otherwise draw with the previous frame's camera
+      glBindBufferRange(GL_UNIFORM_BUFFER, FRAME_DATA_BINDING, frameData->id(), frameOffset, sizeof(frame));
+
+    const ShadingUniforms &u = mainUniforms;
     mainShader->use();
 
-    // camera
-    mainShader->set("camPos", g_cam->getPosition());
-    mainShader->set("viewMat", g_cam->computeViewMatrix());
-    mainShader->set("projMat", g_cam->computeProjectionMatrix());
-
-    // light
-    mainShader->set(std::string("lightSrc.position"), light.position);
-    mainShader->set(std::string("lightSrc.color"), light.color);
-    mainShader->set(std::string("lightSrc.intensity"), light.intensity);
-
     // back-wall
-    mainShader->set("material.albedo", glm::vec3(0.29, 0.51, 0.82)); // default value if the texture was not loaded
-    mainShader->set("material.albedoTexLoaded", 0);
-    mainShader->set("material.normalTex", (int)g_normalTexOnGPU);
-    mainShader->set("material.normalTexLoaded", 1);
-    mainShader->set("modelMat", planeMat);
-    mainShader->set("normMat", glm::mat3(glm::inverseTranspose(planeMat)));
+    mainShader->set(u.albedo, glm::vec3(0.29, 0.51, 0.82)); // default value if the texture was not loaded
+    mainShader->set(u.albedoTexLoaded, 0);
+    mainShader->set(u.normalTex, (int)g_normalTexOnGPU);
+    mainShader->set(u.normalTexLoaded, 1);
+    mainShader->set(u.modelMat, planeMat);
+    mainShader->set(u.normMat, glm::mat3(planeMat)); // rigid transforms: no inverse transpose needed
     plane->render();
 
     // floor
-    mainShader->set("material.albedo", glm::vec3(0.8, 0.8, 0.9));
-    mainShader->set("material.albedoTexLoaded", 0);
-    mainShader->set("material.normalTexLoaded", 0);
-    mainShader->set("modelMat", floorMat);
-    mainShader->set("normMat", glm::mat3(glm::inverseTranspose(floorMat)));
+    mainShader->set(u.albedo, glm::vec3(0.8, 0.8, 0.9));
+    mainShader->set(u.albedoTexLoaded, 0);
+    mainShader->set(u.normalTexLoaded, 0);
+    mainShader->set(u.modelMat, floorMat);
+    mainShader->set(u.normMat, glm::mat3(floorMat));
     plane->render();
 
-    // rigid
-    mainShader->set("material.albedo", glm::vec3(1, 0.71, 0.29));
-    mainShader->set("material.albedoTex", (int)g_albedoTexOnGPU);
-    mainShader->set("material.albedoTexLoaded", 1);
-    mainShader->set("material.normalTexLoaded", 0);
-    mainShader->set("modelMat", rigidMat);
-    mainShader->set("normMat", glm::mat3(glm::inverseTranspose(rigidMat)));
-    rigid->render();
+    // rigid bodies: one draw call for all the instances of the shape
+    rigids->gather(solver.bodies());
+    rigids->upload();
+    const ShadingUniforms &v = instancedUniforms;
+    instancedShader->use();
+    instancedShader->set(v.albedo, glm::vec3(1, 0.71, 0.29));
+    instancedShader->set(v.albedoTex, (int)g_albedoTexOnGPU);
+    instancedShader->set(v.albedoTexLoaded, 1);
+    instancedShader->set(v.normalTexLoaded, 0);
+    rigids->render();
 
-    mainShader->stop();
+    ShaderProgram::stop();
+    frameData->fence();
 
     if(saveScreenShot) {
       std::stringstream fpath;
@@ -397,6 +439,13 @@ void initOpenGL()
   try {
     g_scene.mainShader = ShaderProgram::genBasicShaderProgram("src/vertexShader.glsl", "src/fragmentShader.glsl");
     g_scene.mainShader->stop();
+    g_scene.instancedShader = ShaderProgram::genBasicShaderProgram("src/instancedVertexShader.glsl", "src/fragmentShader.glsl");
+    g_scene.instancedShader->stop();
+    g_scene.mainShader->bindUniformBlock("FrameData", FRAME_DATA_BINDING);
+    g_scene.instancedShader->bindUniformBlock("FrameData", FRAME_DATA_BINDING);
+    g_scene.frameData = std::make_shared<StreamBuffer>(GL_UNIFORM_BUFFER);
+    g_scene.mainUniforms.locate(*g_scene.mainShader);
+    g_scene.instancedUniforms.locate(*g_scene.instancedShader);
   } catch(std::exception &e) {
     exitOnCriticalError(std::string("[Error loading shader program]") + e.what());
   }
@@ -414,15 +463,30 @@ void initScene()
   {
     g_scene.rigid = std::make_shared<Mesh>();
     g_scene.rigid->addBox(.1f, .1f, .1f);
-    g_scene.rigid->init();
+    optimizeMesh(g_scene.rigid);
+    g_scene.rigid->init(true);
+    g_scene.rigids = std::make_shared<InstanceBatch>(g_scene.rigid);
 
     // for the solver
     g_scene.rigidAtt = std::make_shared<Box>(.1f, .1f, .1f);
     g_scene.solver.init(g_scene.rigidAtt.get());
+    g_scene.solver.addStaticPlane(Vec3f(0, 1, 0), Vec3f(0, -1, 0)); // floor
+    g_scene.solver.addStaticPlane(Vec3f(0, 0, 1), Vec3f(0, 0, -1)); // back-wall
+    {
+      // one-time kick on a corner, one frame after the start
+      std::shared_ptr<ScheduledImpulses> kick = std::make_shared<ScheduledImpulses>();
+      kick->addImpulse(1.0f/60.0f, 0, Vec3f(0.15f, 0.25f, 0.03f)/60.0f, g_scene.rigidAtt->vdata0[0]);
+      g_scene.solver.addForceGenerator(kick);
+    }
+    g_scene.stepper.init(&g_scene.solver);
+    g_scene.stepper.setReportCallback([](const AdaptiveStepper::StepReport &r) {
+      if(r.accepted)
+        std::cout << "t=" << r.t << " (dt=" << r.dt << ", err=" << r.error << ")" << std::endl;
+    });
 
     g_scene.plane = std::make_shared<Mesh>();
     g_scene.plane->addPlane();
-    g_scene.plane->init();
+    g_scene.plane->init(true);
     g_scene.planeMat = glm::translate(glm::mat4(1.0), glm::vec3(0, 0, -1.0));
     g_scene.floorMat = glm::translate(glm::mat4(1.0), glm::vec3(0, -1.0, 0))*
       glm::rotate(glm::mat4(1.0), (float)(-0.5f*M_PI), glm::vec3(1.0, 0.0, 0.0));
@@ -470,9 +534,12 @@ void init()
 void clear()
 {
   g_cam.reset();
+  g_scene.rigids.reset();
   g_scene.rigid.reset();
   g_scene.plane.reset();
   g_scene.mainShader.reset();
+  g_scene.instancedShader.reset();
+  g_scene.frameData.reset();
   glfwDestroyWindow(g_window);
   glfwTerminate();
 }
@@ -493,13 +560,15 @@ void update(const float currentTime)
     g_appTimer += dt;
     // <---- Update here what needs to be animated over time ---->
 
-    g_scene.solver.step(std::min(dt, 0.017f)); // solve for the next step; avoid any chances of too large time step
-    g_scene.rigidMat = g_scene.rigidAtt->worldMat(); // update position/orientation for rendering
+    g_scene.stepper.advance(std::min(dt, 0.017f)); // solve up to the next frame with adaptive steps; avoid any chances of too large frame time
   }
 }
 
 int main(int argc, char **argv)
 {
+  if(argc > 1 && std::string(argv[1]) == "--check")
+    return runChecks() ? EXIT_FAILURE : EXIT_SUCCESS;
+
   init();
   while(!glfwWindowShouldClose(g_window)) {
     update(static_cast<float>(glfwGetTime()));
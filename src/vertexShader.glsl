@@ -1,10 +1,19 @@
 #version 330 core            // minimal GL version support expected from the GPU
 
 layout(location=0) in vec3 vPosition; // the 1st input attribute is the position (CPU side: glVertexAttrib 0)
-layout(location=1) in vec3 vNormal;
+layout(location=1) in vec2 vNormal;   // octahedral encoding
 layout(location=2) in vec2 vTexCoord;
 
-uniform mat4 modelMat, viewMat, projMat;
+// Per-frame data shared by all programs, std140 layout
+layout(std140) uniform FrameData {
+  mat4 viewMat;
+  mat4 projMat;
+  vec4 camPos;                  // w unused
+  vec4 lightPosition;           // w unused
+  vec4 lightColor;              // rgb: color, a: intensity
+};
+
+uniform mat4 modelMat;
 uniform mat3 normMat;
 
 out vec3 fPositionModel;
@@ -12,10 +21,17 @@ out vec3 fPosition;
 out vec3 fNormal;
 out vec2 fTexCoord;
 
+vec3 octDecode(vec2 e) {
+  vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+  float t = max(-n.z, 0.0);
+  n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+  return normalize(n);
+}
+
 void main() {
   fPositionModel = vPosition;
   fPosition = (modelMat*vec4(vPosition, 1.0)).xyz;
-  fNormal = normMat*vNormal;
+  fNormal = normMat*octDecode(vNormal);
   fTexCoord = vTexCoord;
 
   gl_Position =  projMat*viewMat*modelMat*vec4(vPosition, 1.0); // mandatory